@@ -0,0 +1,156 @@
+// Writes a synthetic config tree for the benchmarks: root.cfg and the files it includes.
+//   g++ -std=c++20 -O2 gen_config.cpp -o gen_config
+//   ./gen_config [options] output_dir
+// Options, defaults in brackets:
+//   --sections N      unordered sections [1000]
+//   --ordered N       ordered sections [100]
+//   --lists N         list sections [100]
+//   --keys N          keys per unordered or ordered section [20]
+//   --value-length N  length of string values [16]
+//   --list-length N   items per list [20]
+//   --depth N         include levels below root.cfg [0]
+//   --fanout N        files included by every file above the last level [2]
+//   --delimiter S     key-value delimiter [" = "]
+//   --size MB         scale the section counts so that the tree is about this big
+//   --seed N          [1]
+// Sections are spread over all files round-robin. The first keys of every section hold an int,
+// a double, a bool and a duration, the rest strings.
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Params {
+    size_t sections = 1000;
+    size_t ordered = 100;
+    size_t lists = 100;
+    size_t keys = 20;
+    size_t valueLength = 16;
+    size_t listLength = 20;
+    size_t depth = 0;
+    size_t fanout = 2;
+    std::string delimiter = " = ";
+    double sizeMB = 0;
+    unsigned seed = 1;
+};
+
+static int usage() {
+    std::cerr << "usage: gen_config [--sections N] [--ordered N] [--lists N] [--keys N] [--value-length N]" << std::endl
+              << "                  [--list-length N] [--depth N] [--fanout N] [--delimiter S] [--size MB]" << std::endl
+              << "                  [--seed N] output_dir" << std::endl;
+    return 2;
+}
+
+class Generator {
+   public:
+    explicit Generator(const Params& params) : params(params), random(params.seed) {}
+
+    std::string value(size_t key) {
+        switch (key) {
+            case 0: return std::to_string(random() % 100000);
+            case 1: return std::to_string(random() % 100000) + "." + std::to_string(random() % 1000);
+            case 2: return random() % 2 ? "true" : "false";
+            case 3: return std::to_string(random() % 1000) + "ms";
+        }
+        return text(params.valueLength);
+    }
+
+    std::string text(size_t length) {
+        static const char letters[] = "abcdefghijklmnopqrstuvwxyz0123456789_-./";
+        std::string res(length, ' ');
+        for (char& c : res) c = letters[random() % (sizeof(letters) - 1)];
+        return res;
+    }
+
+    void unordered(std::ostream& out, size_t index) {
+        out << "[section_" << index << "]\n";
+        for (size_t key = 0; key < params.keys; ++key) out << "key_" << key << params.delimiter << value(key) << "\n";
+    }
+
+    void ordered(std::ostream& out, size_t index) {
+        out << "<ordered_" << index << ">\n";
+        for (size_t key = 0; key < params.keys; ++key) out << "key_" << key << params.delimiter << value(key) << "\n";
+    }
+
+    void list(std::ostream& out, size_t index) {
+        out << "{list_" << index << "}\n";
+        for (size_t item = 0; item < params.listLength; ++item) out << text(params.valueLength) << "\n";
+    }
+
+    // bytes of one section of each kind, roughly
+    double sectionBytes() const {
+        size_t numbers = std::min<size_t>(params.keys, 4);
+        return 16 + params.keys * (7.0 + params.delimiter.length()) + numbers * 6.0 + (params.keys - numbers) * params.valueLength;
+    }
+    double listBytes() const { return 12 + params.listLength * (params.valueLength + 1.0); }
+
+   private:
+    const Params& params;
+    std::mt19937 random;
+};
+
+int main(int argc, char** argv) {
+    Params params;
+    fs::path output;
+    for (int i = 1; i < argc; ++i) {
+        auto number = [&] { return i + 1 < argc ? std::stoul(argv[++i]) : throw std::invalid_argument(argv[i]); };
+        try {
+            if (strcmp(argv[i], "--sections") == 0) params.sections = number();
+            else if (strcmp(argv[i], "--ordered") == 0) params.ordered = number();
+            else if (strcmp(argv[i], "--lists") == 0) params.lists = number();
+            else if (strcmp(argv[i], "--keys") == 0) params.keys = number();
+            else if (strcmp(argv[i], "--value-length") == 0) params.valueLength = number();
+            else if (strcmp(argv[i], "--list-length") == 0) params.listLength = number();
+            else if (strcmp(argv[i], "--depth") == 0) params.depth = number();
+            else if (strcmp(argv[i], "--fanout") == 0) params.fanout = std::max<size_t>(1, number());
+            else if (strcmp(argv[i], "--seed") == 0) params.seed = number();
+            else if (strcmp(argv[i], "--delimiter") == 0 && i + 1 < argc) params.delimiter = argv[++i];
+            else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) params.sizeMB = std::stod(argv[++i]);
+            else if (argv[i][0] == '-' || !output.empty()) return usage();
+            else output = argv[i];
+        } catch (std::exception&) {
+            return usage();
+        }
+    }
+    if (output.empty()) return usage();
+
+    Generator generator(params);
+    if (params.sizeMB > 0) {
+        double bytes = (params.sections + params.ordered) * generator.sectionBytes() + params.lists * generator.listBytes();
+        double scale = bytes > 0 ? params.sizeMB * (1 << 20) / bytes : 0;
+        params.sections = static_cast<size_t>(params.sections * scale + 0.5);
+        params.ordered = static_cast<size_t>(params.ordered * scale + 0.5);
+        params.lists = static_cast<size_t>(params.lists * scale + 0.5);
+    }
+
+    // files level by level, file i includes files i * fanout + 1 ... i * fanout + fanout
+    size_t files = 0, width = 1;
+    for (size_t level = 0; level <= params.depth; ++level, width *= params.fanout) files += width;
+    size_t parents = files - width / params.fanout;  // all but the last level
+
+    fs::create_directories(output);
+    std::vector<std::ofstream> outs;
+    for (size_t i = 0; i < files; ++i) {
+        outs.emplace_back(output / (i == 0 ? std::string("root.cfg") : "part_" + std::to_string(i) + ".cfg"));
+        if (!outs.back()) {
+            std::cerr << "can not write to " << output << std::endl;
+            return 1;
+        }
+        if (i < parents)
+            for (size_t child = i * params.fanout + 1; child <= i * params.fanout + params.fanout; ++child)
+                outs.back() << "!include part_" << child << ".cfg\n";
+    }
+    for (size_t i = 0; i < params.sections; ++i) generator.unordered(outs[i % files], i);
+    for (size_t i = 0; i < params.ordered; ++i) generator.ordered(outs[i % files], i);
+    for (size_t i = 0; i < params.lists; ++i) generator.list(outs[i % files], i);
+    for (std::ofstream& out : outs) out.close();
+
+    std::cout << output / "root.cfg" << ": " << files << " files, " << params.sections << " unordered, " << params.ordered
+              << " ordered, " << params.lists << " list sections" << std::endl;
+}
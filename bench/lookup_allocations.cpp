@@ -0,0 +1,79 @@
+// Counts heap allocations and time per lookup for the string_view based lookup API.
+//   g++ -std=c++20 -O2 -I../src lookup_allocations.cpp -o lookup_allocations
+//   ./lookup_allocations ../example/example.cfg
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "cfg_parser.hpp"
+
+static size_t allocations = 0;
+static volatile size_t sink = 0;
+
+// the replacements below pair malloc with free themselves, GCC only sees new paired with free
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, std::align_val_t align) {
+    ++allocations;
+    size_t a = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+template <class F>
+void measure(const char* name, size_t iterations, F&& lookup) {
+    size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) sink = sink + lookup();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    std::cout << name << ": " << ns << " ns/lookup, "
+              << static_cast<double>(allocations - before) / iterations << " allocations/lookup" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const char* file = argc > 1 ? argv[1] : "../example/example.cfg";
+    const size_t iterations = 1000000;
+    cfgparser::Config config(file);
+
+    measure("get(literal, literal) hit", iterations, [&] {
+        return config->get("DatabaseConnection", "db_port").value.size();
+    });
+    measure("find(literal, literal) hit", iterations, [&] {
+        return config->find("DatabaseConnection", "db_port") != nullptr;
+    });
+    measure("find(literal, literal) missing key", iterations, [&] {
+        return config->find("DatabaseConnection", "db_timeout") != nullptr;
+    });
+    measure("find(literal, literal) missing section", iterations, [&] {
+        return config->find("Nope", "db_port") != nullptr;
+    });
+    measure("contains(literal, literal)", iterations, [&] { return config->contains("ServiceLimits", "max_memory_usage"); });
+    measure("findOrdered(literal, literal)", iterations, [&] {
+        return config->findOrdered("DatabaseTable", "age") != nullptr;
+    });
+    measure("findList(literal)", iterations, [&] { return config->findList("AllowedServers") != nullptr; });
+    measure("get(literal, literal) miss, throwing", iterations / 100, [&] {
+        try {
+            return config->get("DatabaseConnection", "db_timeout").value.size();
+        } catch (const std::runtime_error&) {
+            return size_t(0);
+        }
+    });
+    return 0;
+}
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Builds the benchmarks, writes a synthetic config with gen_config and runs the suite on it.
+# Arguments go to gen_config (see gen_config.cpp), results are JSON lines on stdout.
+#   bench/run.sh --size 64 --depth 2
+# CXX, CXXFLAGS, BUILD (build and data directory, bench/build) and SUITE (suite options) can be
+# set in the environment.
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--O2}
+BUILD=${BUILD:-build}
+
+mkdir -p "$BUILD"
+for source in *.cpp; do
+    $CXX -std=c++20 $CXXFLAGS -pthread -I../src "$source" -o "$BUILD/${source%.cpp}"
+done
+
+delimiter=" = "
+prev=
+for arg in "$@"; do
+    if [ "$prev" = "--delimiter" ]; then delimiter=$arg; fi
+    prev=$arg
+done
+
+"$BUILD/gen_config" "$@" "$BUILD/data" >&2
+"$BUILD/suite" --delimiter "$delimiter" $SUITE "$BUILD/data/root.cfg"
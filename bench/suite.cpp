@@ -0,0 +1,188 @@
+// Parse, lookup, conversion, dump and global read benchmarks over one config, usually a tree
+// written by gen_config. Prints one JSON object per result, so runs can be collected and compared.
+//   g++ -std=c++20 -O2 -pthread -I../src suite.cpp -o suite
+//   ./suite [--delimiter S] [--repeat N] [--threads N] root.cfg
+// Every result is the best of --repeat runs [5]. getConfig() and readConfig() reads go from 1 to
+// --threads threads [number of cores], doubling.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "cfg_parser.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static volatile size_t sink = 0;
+
+static void consume(size_t n) { sink = sink + n; }
+
+// best time of 'repeat' runs of 'run', in seconds
+template <class F>
+double best(int repeat, F&& run) {
+    double res = 0;
+    for (int i = 0; i < repeat; ++i) {
+        auto start = Clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (i == 0 || seconds < res) res = seconds;
+    }
+    return res;
+}
+
+// one line of output: {"bench": "name", "key": value, ...}
+class Result {
+   public:
+    explicit Result(const std::string& name) { out << "{\"bench\": \"" << name << "\""; }
+
+    template <class T>
+    Result& operator()(const char* key, const T& value) {
+        out << ", \"" << key << "\": " << value;
+        return *this;
+    }
+
+    ~Result() { std::cout << out.str() << "}" << std::endl; }
+
+   private:
+    std::ostringstream out;
+};
+
+// calls of 'read' per second over all threads, 'read' returns 1 per read
+template <class Read>
+double readsPerSecond(unsigned threads, Read&& read) {
+    const auto duration = std::chrono::milliseconds(300);
+    std::atomic<bool> start{false}, stop{false};
+    std::vector<size_t> counts(threads * 16, 0);  // padded, one cache line per thread
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            while (!start.load(std::memory_order_acquire)) {}
+            size_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; ++i) n += read();
+            }
+            counts[t * 16] = n;
+        });
+    }
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for (auto& worker : workers) worker.join();
+    size_t total = 0;
+    for (unsigned t = 0; t < threads; ++t) total += counts[t * 16];
+    return total / std::chrono::duration<double>(duration).count();
+}
+
+int main(int argc, char** argv) {
+    cfgparser::Options options;
+    int repeat = 5;
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    cfgparser::fs::path file;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--delimiter") == 0 && i + 1 < argc) options.delimiter = argv[++i];
+        else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) repeat = std::max(1, std::stoi(argv[++i]));
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) maxThreads = std::max(1, std::stoi(argv[++i]));
+        else file = argv[i];
+    }
+    if (file.empty()) {
+        std::cerr << "usage: suite [--delimiter S] [--repeat N] [--threads N] root.cfg" << std::endl;
+        return 2;
+    }
+
+    // parse throughput over the whole include tree
+    cfgparser::Config config(file, options);
+    size_t bytes = 0, lines = 0;
+    for (const cfgparser::fs::path& parsed : config->getParsedFileNames()) {
+        std::ifstream in(parsed, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        bytes += text.size();
+        lines += std::count(text.begin(), text.end(), '\n');
+    }
+    double parse = best(repeat, [&] { consume(cfgparser::Config(file, options)->getParsedFileNames().size()); });
+    Result{"parse"}("files", config->getParsedFileNames().size())("bytes", bytes)("lines", lines)("seconds", parse)(
+        "mb_per_s", bytes / parse / (1 << 20)
+    )("lines_per_s", lines / parse);
+
+    // lookups of existing keys in random order, names built up front
+    std::mt19937 random(1);
+    std::vector<std::pair<std::string, std::string>> unordered, ordered;
+    std::vector<std::string> lists;
+    for (const auto& [name, section] : config->getAllUnordered())
+        for (const auto& [key, value] : section) unordered.push_back({name, key});
+    for (const auto& [name, section] : config->getAllOrdered())
+        for (const auto& [key, value] : section) ordered.push_back({name, key});
+    for (const auto& [name, section] : config->getAllLists()) lists.push_back(name);
+    std::shuffle(unordered.begin(), unordered.end(), random);
+    std::shuffle(ordered.begin(), ordered.end(), random);
+    std::shuffle(lists.begin(), lists.end(), random);
+
+    auto lookups = [&](const char* name, const auto& keys, auto&& lookup) {
+        if (keys.empty()) return;
+        double seconds = best(repeat, [&] {
+            size_t n = 0;
+            for (const auto& key : keys) n += lookup(key);
+            consume(n);
+        });
+        Result{name}("lookups", keys.size())("ns_per_op", seconds * 1e9 / keys.size());
+    };
+    lookups("get", unordered, [&](const auto& k) { return config->get(k.first, k.second).value.size(); });
+    lookups("getOrdered", ordered, [&](const auto& k) { return config->getOrdered(k.first, k.second).value.size(); });
+    lookups("getList", lists, [&](const std::string& name) { return config->getList(name).size(); });
+
+    // conversions of fresh values (parsing) and of values converted before (cache)
+    std::vector<std::string> integers, doubles, bools, durations;
+    for (size_t i = 0; i < 100000; ++i) {
+        integers.push_back(std::to_string(random() % 1000000));
+        doubles.push_back(std::to_string(random() % 100000) + "." + std::to_string(random() % 1000));
+        bools.push_back(random() % 2 ? "true" : "false");
+        durations.push_back(std::to_string(random() % 1000) + "ms");
+    }
+    auto conversions = [&](const char* name, const std::vector<std::string>& texts, auto&& convert) {
+        std::vector<cfgparser::Value> values;
+        auto run = [&] {
+            size_t n = 0;
+            for (const cfgparser::Value& value : values) n += convert(value);
+            consume(n);
+        };
+        double fresh = 0;
+        for (int i = 0; i < repeat; ++i) {
+            values.assign(texts.begin(), texts.end());
+            double seconds = best(1, run);
+            if (i == 0 || seconds < fresh) fresh = seconds;
+        }
+        double cached = best(repeat, run);
+        Result{name}("values", texts.size())("ns_per_op", fresh * 1e9 / texts.size())(
+            "cached_ns_per_op", cached * 1e9 / texts.size()
+        );
+    };
+    conversions("asInt", integers, [](const cfgparser::Value& v) { return static_cast<size_t>(v.asInt()); });
+    conversions("asDouble", doubles, [](const cfgparser::Value& v) { return static_cast<size_t>(v.asDouble()); });
+    conversions("asBool", bools, [](const cfgparser::Value& v) { return static_cast<size_t>(v.asBool()); });
+    conversions("asDuration", durations, [](const cfgparser::Value& v) {
+        return static_cast<size_t>(v.as<std::chrono::milliseconds>().count());
+    });
+
+    size_t dumped = config->dumpSize();
+    double dump = best(repeat, [&] { consume(config->dump().size()); });
+    Result{"dump"}("bytes", dumped)("seconds", dump)("mb_per_s", dumped / dump / (1 << 20));
+
+    // the same key read through the global config from more and more threads: getConfig() (shared
+    // reference count) against readConfig() (thread-local cached pointer)
+    if (!unordered.empty()) {
+        cfgparser::publishConfig(config);
+        const auto& [section, key] = unordered.front();
+        for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+            double reads = readsPerSecond(threads, [&] { return cfgparser::getConfig()->find(section, key) != nullptr; });
+            Result{"getConfig"}("threads", threads)("reads_per_s", reads);
+            reads = readsPerSecond(threads, [&] { return cfgparser::readConfig().find(section, key) != nullptr; });
+            Result{"readConfig"}("threads", threads)("reads_per_s", reads);
+            if (threads == maxThreads) break;
+        }
+    }
+}
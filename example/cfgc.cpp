@@ -0,0 +1,57 @@
+// Compiles config files into a binary image for cfgparser::CompiledConfig.
+//   g++ -std=c++20 -O2 -I../src cfgc.cpp -o cfgc
+//   ./cfgc example.cfg -o example.cfgimg
+#include <cstring>
+#include <iostream>
+#include "cfg_parser.hpp"
+
+static int usage() {
+    std::cerr << "usage: cfgc [-d delimiter] [--check] -o output input.cfg..." << std::endl;
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    cfgparser::Options options;
+    std::vector<cfgparser::fs::path> inputs;
+    cfgparser::fs::path output;
+    bool check = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) output = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) options.delimiter = argv[++i];
+        else if (strcmp(argv[i], "--check") == 0) check = true;
+        else if (argv[i][0] == '-') return usage();
+        else inputs.push_back(argv[i]);
+    }
+    if (inputs.empty() || output.empty()) return usage();
+
+    try {
+        cfgparser::Config config(inputs, options);
+        config->compile(output);
+        if (check) {
+            // every value must read back the same from the image
+            cfgparser::CompiledConfig image(output);
+            for (const auto& [section, entries] : config->getAllUnordered())
+                for (const auto& [key, value] : entries)
+                    if (image.get(section, key) != value.value) throw std::runtime_error("image differs at [" + section + "] " + key);
+            for (const auto& [section, entries] : config->getAllOrdered()) {
+                auto compiled = image.getOrderedSection(section);
+                if (compiled.size() != entries.size()) throw std::runtime_error("image differs at <" + section + ">");
+                for (size_t i = 0; i < entries.size(); ++i)
+                    if (compiled[i].first != entries[i].first || compiled[i].second != entries[i].second.value)
+                        throw std::runtime_error("image differs at <" + section + "> " + entries[i].first);
+            }
+            for (const auto& [section, entries] : config->getAllLists()) {
+                auto compiled = image.getList(section);
+                if (compiled.size() != entries.size()) throw std::runtime_error("image differs at {" + section + "}");
+                for (size_t i = 0; i < entries.size(); ++i)
+                    if (compiled[i] != entries[i].value) throw std::runtime_error("image differs at {" + section + "}");
+            }
+        }
+        std::cout << output.string() << ": " << config->getParsedFileNames().size() << " files, "
+                  << cfgparser::fs::file_size(output) << " bytes" << std::endl;
+    } catch (std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
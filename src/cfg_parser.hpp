@@ -1,17 +1,61 @@
 #ifndef CFG_PARSER_HPP
 #define CFG_PARSER_HPP
+// 2.0 replaced the std:: section containers of 1.x, see "Upgrading from 1.x" in README.md
+#define CFGPARSER_VERSION_MAJOR 2
+#define CFGPARSER_VERSION_MINOR 0
 #include <string.h>  //strerror()
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <exception>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <sstream>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 #include <version>
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#define CFGPARSER_HAS_UNISTD 1
+#endif
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CFGPARSER_HAS_MMAP 1
+#endif
+#if __has_include(<sys/inotify.h>)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define CFGPARSER_HAS_INOTIFY 1
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(CFGPARSER_NO_SIMD)
+#include <immintrin.h>
+#define CFGPARSER_HAS_X86_SIMD 1
+#endif
 #if __cpp_lib_optional
 #include <optional>
 #endif
@@ -20,40 +64,281 @@ namespace cfgparser {
 
 namespace fs = std::filesystem;
 
+namespace detail {
+
+// Conversions behind Value::as*(). Like std::sto* they skip leading whitespace, accept a sign and
+// ignore anything after the number, but they do not depend on the locale and never throw.
+
+inline std::string_view skipSpaces(std::string_view s) {
+    size_t i = 0;
+    while (i < s.length() && isspace(static_cast<unsigned char>(s[i]))) ++i;
+    return s.substr(i);
+}
+
+inline bool parseInteger(std::string_view s, long long& out) {
+    s = skipSpaces(s);
+    if (s.length() > 1 && s[0] == '+' && s[1] != '-') s.remove_prefix(1);
+    return std::from_chars(s.data(), s.data() + s.length(), out).ec == std::errc();
+}
+
+// Fast path for the plain "-123" form: an optional '-' and up to 18 digits, nothing around them.
+// Eight digits are converted at a time with SWAR arithmetic. Returns false for anything else,
+// parseInteger() then decides.
+inline bool parseDigits(std::string_view s, long long& out) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    bool negative = !s.empty() && s[0] == '-';
+    if (negative) s.remove_prefix(1);
+    if (s.empty() || s.length() > 18) return false;
+    uint64_t res = 0;
+    size_t i = 0;
+    for (; i + 8 <= s.length(); i += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, s.data() + i, 8);
+        if ((chunk & 0xF0F0F0F0F0F0F0F0) != 0x3030303030303030 ||
+            ((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) != 0x3030303030303030)
+            return false;
+        chunk -= 0x3030303030303030;
+        chunk = chunk * 10 + (chunk >> 8);
+        chunk = ((chunk & 0x000000FF000000FF) * 0x000F424000000064 +
+                 ((chunk >> 16) & 0x000000FF000000FF) * 0x0000271000000001) >> 32;
+        res = res * 100000000 + static_cast<uint32_t>(chunk);
+    }
+    for (; i < s.length(); ++i) {
+        unsigned digit = static_cast<unsigned char>(s[i]) - '0';
+        if (digit > 9) return false;
+        res = res * 10 + digit;
+    }
+    out = negative ? -static_cast<long long>(res) : static_cast<long long>(res);
+    return true;
+#else
+    (void)s;
+    (void)out;
+    return false;
+#endif
+}
+
+inline bool parseUnsigned(std::string_view s, unsigned long long& out) {
+    s = skipSpaces(s);
+    if (s.length() > 1 && s[0] == '+') s.remove_prefix(1);
+    return std::from_chars(s.data(), s.data() + s.length(), out).ec == std::errc();
+}
+
+inline bool parseDouble(std::string_view s, double& out) {
+    s = skipSpaces(s);
+#if __cpp_lib_to_chars
+    bool negative = !s.empty() && s[0] == '-';
+    if (!s.empty() && (s[0] == '+' || s[0] == '-')) s.remove_prefix(1);
+    if (s.empty() || s[0] == '+' || s[0] == '-') return false;
+    std::chars_format format = std::chars_format::general;
+    if (s.length() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        s.remove_prefix(2);
+        format = std::chars_format::hex;
+    }
+    if (std::from_chars(s.data(), s.data() + s.length(), out, format).ec != std::errc()) return false;
+    if (negative) out = -out;
+    return true;
+#else
+    try {
+        out = std::stod(std::string(s));
+        return true;
+    } catch (std::exception&) {
+        return false;
+    }
+#endif
+}
+
+inline bool parseBool(std::string_view s, bool& out) {
+    if (s == "true") out = true;
+    else if (s == "false") out = false;
+    else return false;
+    return true;
+}
+
+// "150ms", "2s", "1.5h"; a number without a suffix is taken in the units of Duration
+template <class Duration>
+bool parseDuration(std::string_view s, Duration& out) {
+    s = skipSpaces(s);
+    const char* end = s.data() + s.length();
+    long long count = 0;
+    double fraction = 0;
+    auto res = std::from_chars(s.data(), end, count);
+    if (res.ec != std::errc()) return false;
+    bool integral = res.ptr == end || *res.ptr != '.';
+    if (!integral) {
+        if (!parseDouble(s, fraction)) return false;
+        res.ptr = std::find_if(res.ptr + 1, end, [](char c) { return !isdigit(static_cast<unsigned char>(c)); });
+    }
+    std::string_view unit(res.ptr, end - res.ptr);
+    while (!unit.empty() && unit.front() == ' ') unit.remove_prefix(1);
+    while (!unit.empty() && unit.back() == ' ') unit.remove_suffix(1);
+
+    auto convert = [&](auto period) {
+        using Source = std::chrono::duration<long long, decltype(period)>;
+        using SourceReal = std::chrono::duration<double, decltype(period)>;
+        if (integral) out = std::chrono::duration_cast<Duration>(Source(count));
+        else out = std::chrono::duration_cast<Duration>(SourceReal(fraction));
+        return true;
+    };
+    if (unit.empty()) return convert(typename Duration::period());
+    if (unit == "ns") return convert(std::nano());
+    if (unit == "us") return convert(std::micro());
+    if (unit == "ms") return convert(std::milli());
+    if (unit == "s") return convert(std::ratio<1>());
+    if (unit == "m" || unit == "min") return convert(std::ratio<60>());
+    if (unit == "h") return convert(std::ratio<3600>());
+    if (unit == "d") return convert(std::ratio<86400>());
+    return false;
+}
+
+template <class T>
+struct is_duration : std::false_type {};
+template <class Rep, class Period>
+struct is_duration<std::chrono::duration<Rep, Period>> : std::true_type {};
+
+// Typed results of a Value, allocated on its first conversion. Flags are published with release
+// after the cached numbers are stored.
+struct TypeCache {
+    std::atomic<uint8_t> flags{0};
+    std::atomic<long long> integer{0};
+    std::atomic<double> real{0};
+
+    TypeCache() = default;
+    TypeCache(const TypeCache& other)
+        : flags(other.flags.load(std::memory_order_acquire)),
+          integer(other.integer.load(std::memory_order_relaxed)),
+          real(other.real.load(std::memory_order_relaxed)) {}
+};
+
+}  // namespace detail
+
 class Value {
    public:
     std::string value;
 
     Value(const std::string& value) : value(value) {}
+    Value(std::string&& value) : value(std::move(value)) {}
     Value(const char* value) : value(value) {}
     Value() {}
 
+    Value(const Value& other) : value(other.value) { copyCache(other); }
+    Value(Value&& other) noexcept : value(std::move(other.value)) { moveCache(other); }
+    Value& operator=(const Value& other) {
+        value = other.value;
+        copyCache(other);
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        value = std::move(other.value);
+        moveCache(other);
+        return *this;
+    }
+    ~Value() { delete cache.load(std::memory_order_relaxed); }
+
+    // Typed results are cached after the first conversion and reused by later calls, from any thread.
+    // The cache is allocated by the first conversion, a Value never read typed only holds a null
+    // pointer. It is reset when a new Value is assigned; do not edit 'value' in place after
+    // reading it typed.
+
     int asInt() const {
-        try {
-            return std::stoi(value);
-        } catch (std::exception& ex) {
+        long long res;
+        if (!cachedInteger(res) || res < std::numeric_limits<int>::min() || res > std::numeric_limits<int>::max())
             throw std::runtime_error("Can not cast to int: '" + value + "'");
-        }
+        return static_cast<int>(res);
     }
     double asDouble() const {
-        try {
-            return std::stod(value);
-        } catch (std::exception& ex) {
-            throw std::runtime_error("Can not cast to double: '" + value + "'");
-        }
+        double res;
+        if (!cachedDouble(res)) throw std::runtime_error("Can not cast to double: '" + value + "'");
+        return res;
     }
     long long asLongLong() const {
-        try {
-            return std::stoll(value);
-        } catch (std::exception& ex) {
-            throw std::runtime_error("Can not cast to long long: '" + value + "'");
-        }
+        long long res;
+        if (!cachedInteger(res)) throw std::runtime_error("Can not cast to long long: '" + value + "'");
+        return res;
     }
     bool asBool() const {
-        if (value == "true") return true;
-        if (value == "false") return false;
-        throw std::runtime_error("Can not cast to bool: '" + value + "'");
+        bool res;
+        if (!cachedBool(res)) throw std::runtime_error("Can not cast to bool: '" + value + "'");
+        return res;
+    }
+
+    // Generic conversion to bool, any integer or floating point type, std::string or std::chrono::duration.
+    // Returns false and leaves 'out' untouched if the value does not fit into T.
+    template <class T>
+    bool tryAs(T& out) const {
+        if constexpr (std::is_same_v<T, bool>) {
+            return cachedBool(out);
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            long long res;
+            if (!cachedInteger(res) || res < std::numeric_limits<T>::min() || res > std::numeric_limits<T>::max())
+                return false;
+            out = static_cast<T>(res);
+            return true;
+        } else if constexpr (std::is_integral_v<T>) {
+            long long res;
+            unsigned long long ures;
+            if (cachedInteger(res)) {
+                if (res < 0) return false;
+                ures = static_cast<unsigned long long>(res);
+            } else if (!detail::parseUnsigned(value, ures)) {
+                return false;
+            }
+            if (ures > std::numeric_limits<T>::max()) return false;
+            out = static_cast<T>(ures);
+            return true;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            double res;
+            if (!cachedDouble(res)) return false;
+            out = static_cast<T>(res);
+            return true;
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            out = value;
+            return true;
+        } else if constexpr (detail::is_duration<T>::value) {
+            return detail::parseDuration(value, out);
+        } else {
+            static_assert(!sizeof(T), "unsupported conversion");
+        }
+    }
+
+#if __cpp_lib_optional
+    template <class T>
+    std::optional<T> tryAs() const {
+        T res;
+        if (!tryAs(res)) return std::nullopt;
+        return res;
+    }
+#endif
+
+    template <class T>
+    T as() const {
+        T res;
+        if (!tryAs(res)) throw std::runtime_error("Can not cast to " + typeName<T>() + ": '" + value + "'");
+        return res;
+    }
+
+    // name of T in conversion errors
+    template <class T>
+    static std::string typeName() {
+        if constexpr (std::is_same_v<T, bool>) return "bool";
+        else if constexpr (std::is_same_v<T, int>) return "int";
+        else if constexpr (std::is_same_v<T, long long>) return "long long";
+        else if constexpr (std::is_same_v<T, double>) return "double";
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) return "integer";
+        else if constexpr (std::is_integral_v<T>) return "unsigned integer";
+        else if constexpr (std::is_floating_point_v<T>) return "floating point";
+        else return "duration";
+    }
+
+    // runs the integer, floating point and bool conversions once so that later reads only load the cache
+    void cacheTypes() const {
+        long long i;
+        double d;
+        bool b;
+        cachedInteger(i);
+        cachedDouble(d);
+        cachedBool(b);
     }
+
     operator std::string() const { return value; }
 
     bool operator==(const Value& v) const { return value == v.value; }
@@ -62,13 +347,541 @@ class Value {
         out << v.value;
         return out;
     }
+
+   private:
+    enum CacheFlags : uint8_t {
+        INTEGER_DONE = 1,
+        INTEGER_OK = 2,
+        DOUBLE_DONE = 4,
+        DOUBLE_OK = 8,
+        BOOL_DONE = 16,
+        BOOL_OK = 32,
+        BOOL_TRUE = 64
+    };
+
+    mutable std::atomic<detail::TypeCache*> cache{nullptr};
+
+    void copyCache(const Value& other) {
+        const detail::TypeCache* source = other.cache.load(std::memory_order_acquire);
+        delete cache.exchange(source ? new detail::TypeCache(*source) : nullptr, std::memory_order_acq_rel);
+    }
+
+    void moveCache(Value& other) {
+        delete cache.exchange(other.cache.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_acq_rel);
+    }
+
+    // the cache, allocated by the first thread that needs it
+    detail::TypeCache& typeCache() const {
+        detail::TypeCache* res = cache.load(std::memory_order_acquire);
+        if (res) return *res;
+        auto created = std::make_unique<detail::TypeCache>();
+        if (cache.compare_exchange_strong(res, created.get(), std::memory_order_acq_rel)) return *created.release();
+        return *res;
+    }
+
+    bool cachedInteger(long long& out) const {
+        detail::TypeCache& c = typeCache();
+        uint8_t flags = c.flags.load(std::memory_order_acquire);
+        if (!(flags & INTEGER_DONE)) {
+            long long res = 0;
+            bool ok = detail::parseInteger(value, res);
+            c.integer.store(res, std::memory_order_relaxed);
+            flags = c.flags.fetch_or(INTEGER_DONE | (ok ? INTEGER_OK : 0), std::memory_order_release);
+            flags |= INTEGER_DONE | (ok ? INTEGER_OK : 0);
+        }
+        out = c.integer.load(std::memory_order_relaxed);
+        return flags & INTEGER_OK;
+    }
+
+    bool cachedDouble(double& out) const {
+        detail::TypeCache& c = typeCache();
+        uint8_t flags = c.flags.load(std::memory_order_acquire);
+        if (!(flags & DOUBLE_DONE)) {
+            double res = 0;
+            bool ok = detail::parseDouble(value, res);
+            c.real.store(res, std::memory_order_relaxed);
+            flags = c.flags.fetch_or(DOUBLE_DONE | (ok ? DOUBLE_OK : 0), std::memory_order_release);
+            flags |= DOUBLE_DONE | (ok ? DOUBLE_OK : 0);
+        }
+        out = c.real.load(std::memory_order_relaxed);
+        return flags & DOUBLE_OK;
+    }
+
+    bool cachedBool(bool& out) const {
+        detail::TypeCache& c = typeCache();
+        uint8_t flags = c.flags.load(std::memory_order_acquire);
+        if (!(flags & BOOL_DONE)) {
+            bool res = false;
+            bool ok = detail::parseBool(value, res);
+            flags = c.flags.fetch_or(BOOL_DONE | (ok ? BOOL_OK : 0) | (res ? BOOL_TRUE : 0), std::memory_order_release);
+            flags |= BOOL_DONE | (ok ? BOOL_OK : 0) | (res ? BOOL_TRUE : 0);
+        }
+        out = flags & BOOL_TRUE;
+        return flags & BOOL_OK;
+    }
 };
 
 const std::string defaultDelimiter = " = ";
 
-typedef std::unordered_map<std::string, Value> unordered_container;
-typedef std::vector<std::pair<std::string, Value>> ordered_container;
-typedef std::vector<Value> list_container;
+enum SectionType { UNORDERED,
+                   ORDERED,
+                   LIST };
+
+// transparent hash, lets maps keyed by std::string be searched with a std::string_view
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+};
+
+namespace detail {
+
+// Hash index over the elements of a vector, mapping a string key to the position of its first
+// occurrence. The index remembers the buffer, size and edit stamp (see touch()) it was built for
+// and is rebuilt when one of them changes. The first lookup after a change scans the elements
+// instead, the index is built by the next one, so code that keeps editing between lookups does
+// not rebuild it every time. Readers may race to build it; they may still be probing the tables
+// built for the same state, or checking the one that was current before, older tables are freed
+// when a new one is installed.
+class LazyIndex {
+   public:
+    LazyIndex() = default;
+    // an index is never copied, the copy builds its own on demand
+    LazyIndex(const LazyIndex&) noexcept {}
+    LazyIndex& operator=(const LazyIndex&) {
+        reset();
+        return *this;
+    }
+    ~LazyIndex() { reset(); }
+
+    // position of the first element whose 'keyOf(position)' equals 'key', 'count' if none
+    template <class KeyOf>
+    size_t find(const void* data, size_t count, std::string_view key, KeyOf&& keyOf) const {
+        const Table* table = current.load(std::memory_order_acquire);
+        if (!table || table->data != data || table->count != count || table->stamp != stamp) {
+            if (seen.exchange(stamp, std::memory_order_relaxed) != stamp) {
+                for (size_t pos = 0; pos < count; ++pos)
+                    if (keyOf(pos) == key) return pos;
+                return count;
+            }
+            table = build(data, count, keyOf);
+        }
+        size_t mask = table->slots.size() - 1;
+        for (size_t i = std::hash<std::string_view>()(key) & mask;; i = (i + 1) & mask) {
+            uint32_t slot = table->slots[i];
+            if (slot == 0) return count;
+            if (keyOf(slot - 1) == key) return slot - 1;
+        }
+    }
+
+    // The elements may change: called by every non-const member of the container, before it
+    // hands out a reference or changes anything. Not safe against concurrent find().
+    void touch() { ++stamp; }
+
+    // drops the index, not safe against concurrent find()
+    void reset() {
+        Table* table = current.exchange(nullptr);
+        while (table) delete std::exchange(table, table->replaced);
+    }
+
+   private:
+    struct Table {
+        const void* data;
+        size_t count;
+        uint64_t stamp;
+        std::vector<uint32_t> slots;  // position + 1, 0 is an empty slot
+        Table* replaced;
+    };
+    mutable std::atomic<Table*> current{nullptr};
+    mutable std::mutex installing;
+    uint64_t stamp = 1;
+    // stamp of the last lookup that did not find a table for the current state
+    mutable std::atomic<uint64_t> seen{0};
+
+    template <class KeyOf>
+    const Table* build(const void* data, size_t count, KeyOf& keyOf) const {
+        size_t capacity = 2;
+        while (capacity < count * 2) capacity *= 2;
+        auto table = std::make_unique<Table>(Table{data, count, stamp, std::vector<uint32_t>(capacity, 0), nullptr});
+        size_t mask = capacity - 1;
+        for (size_t pos = 0; pos < count; ++pos) {
+            std::string_view key = keyOf(pos);
+            for (size_t i = std::hash<std::string_view>()(key) & mask;; i = (i + 1) & mask) {
+                uint32_t& slot = table->slots[i];
+                if (slot == 0) {
+                    slot = pos + 1;
+                    break;
+                }
+                if (keyOf(slot - 1) == key) break;  // keep the first occurrence
+            }
+        }
+        std::lock_guard<std::mutex> lock(installing);
+        table->replaced = current.load(std::memory_order_relaxed);
+        current.store(table.get(), std::memory_order_release);
+        prune(table.get());
+        return table.release();
+    }
+
+    static bool sameState(const Table* a, const Table* b) {
+        return a->data == b->data && a->count == b->count && a->stamp == b->stamp;
+    }
+
+    // Frees the tables after the newest one built for a different state. The container is not
+    // changed while it is read, so only readers that started after the last change are running,
+    // and they got 'current' either from it or from the table it replaced.
+    void prune(Table* table) const {
+        while (table->replaced && sameState(table->replaced, table)) table = table->replaced;
+        if (!table->replaced) return;
+        Table* stale = std::exchange(table->replaced->replaced, nullptr);
+        while (stale) delete std::exchange(stale, stale->replaced);
+    }
+};
+
+// std::pmr::vector with a LazyIndex that is told about every change: the members that modify
+// the vector or hand out a non-const reference or iterator call LazyIndex::touch(). Changes made
+// through references kept from before a lookup need reindex().
+template <class T>
+class IndexedVector : public std::pmr::vector<T> {
+   public:
+    using base = std::pmr::vector<T>;
+    using typename base::const_iterator;
+    using typename base::iterator;
+    using typename base::reference;
+    using typename base::size_type;
+    using base::base;
+
+    IndexedVector() = default;
+    IndexedVector(const IndexedVector& other) = default;
+    IndexedVector(IndexedVector&& other) = default;
+    IndexedVector(const IndexedVector& other, const typename base::allocator_type& alloc) : base(other, alloc) {}
+    IndexedVector(IndexedVector&& other, const typename base::allocator_type& alloc) : base(std::move(other), alloc) {}
+    IndexedVector& operator=(const IndexedVector& other) {
+        index.touch();
+        base::operator=(other);
+        return *this;
+    }
+    IndexedVector& operator=(IndexedVector&& other) {
+        base::operator=(std::move(other));
+        index.reset();
+        return *this;
+    }
+    IndexedVector& operator=(std::initializer_list<T> items) {
+        index.touch();
+        base::operator=(items);
+        return *this;
+    }
+
+    using base::at;
+    using base::back;
+    using base::begin;
+    using base::data;
+    using base::end;
+    using base::front;
+    using base::operator[];
+    using base::rbegin;
+    using base::rend;
+    reference at(size_type i) { return index.touch(), base::at(i); }
+    reference back() { return index.touch(), base::back(); }
+    iterator begin() { return index.touch(), base::begin(); }
+    T* data() { return index.touch(), base::data(); }
+    iterator end() { return index.touch(), base::end(); }
+    reference front() { return index.touch(), base::front(); }
+    reference operator[](size_type i) { return index.touch(), base::operator[](i); }
+    typename base::reverse_iterator rbegin() { return index.touch(), base::rbegin(); }
+    typename base::reverse_iterator rend() { return index.touch(), base::rend(); }
+
+    void assign(size_type n, const T& item) {
+        index.touch();
+        base::assign(n, item);
+    }
+    template <class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void assign(InputIt first, InputIt last) {
+        index.touch();
+        base::assign(first, last);
+    }
+    void assign(std::initializer_list<T> items) {
+        index.touch();
+        base::assign(items);
+    }
+    void clear() noexcept {
+        index.touch();
+        base::clear();
+    }
+    template <class... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        index.touch();
+        return base::emplace(pos, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    reference emplace_back(Args&&... args) {
+        index.touch();
+        return base::emplace_back(std::forward<Args>(args)...);
+    }
+    iterator erase(const_iterator pos) {
+        index.touch();
+        return base::erase(pos);
+    }
+    iterator erase(const_iterator first, const_iterator last) {
+        index.touch();
+        return base::erase(first, last);
+    }
+    iterator insert(const_iterator pos, const T& item) {
+        index.touch();
+        return base::insert(pos, item);
+    }
+    iterator insert(const_iterator pos, T&& item) {
+        index.touch();
+        return base::insert(pos, std::move(item));
+    }
+    iterator insert(const_iterator pos, size_type n, const T& item) {
+        index.touch();
+        return base::insert(pos, n, item);
+    }
+    template <class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    iterator insert(const_iterator pos, InputIt first, InputIt last) {
+        index.touch();
+        return base::insert(pos, first, last);
+    }
+    iterator insert(const_iterator pos, std::initializer_list<T> items) {
+        index.touch();
+        return base::insert(pos, items);
+    }
+    void pop_back() {
+        index.touch();
+        base::pop_back();
+    }
+    void push_back(const T& item) {
+        index.touch();
+        base::push_back(item);
+    }
+    void push_back(T&& item) {
+        index.touch();
+        base::push_back(std::move(item));
+    }
+    void resize(size_type n) {
+        index.touch();
+        base::resize(n);
+    }
+    void resize(size_type n, const T& item) {
+        index.touch();
+        base::resize(n, item);
+    }
+    void swap(IndexedVector& other) {
+        index.touch();
+        other.index.touch();
+        base::swap(other);
+    }
+
+    // forgets the index, for changes made through references taken before the last lookup
+    void reindex() { index.reset(); }
+
+   protected:
+    // smaller vectors are scanned, that is as fast as hashing the key
+    static constexpr size_t indexThreshold = 16;
+
+    // position of the first element whose 'keyOf' equals 'key', size() if none
+    template <class KeyOf>
+    size_t position(std::string_view key, KeyOf&& keyOf) const {
+        if (this->size() < indexThreshold) {
+            for (size_t pos = 0; pos < this->size(); ++pos)
+                if (keyOf((*this)[pos]) == key) return pos;
+            return this->size();
+        }
+        return index.find(base::data(), this->size(), key, [&](size_t i) { return keyOf((*this)[i]); });
+    }
+
+    void touch() { index.touch(); }
+
+   private:
+    LazyIndex index;
+};
+
+}  // namespace detail
+
+// Entries of an ordered section, in file order. find() returns the first entry with a key, so
+// with duplicate keys the first occurrence wins; iteration still sees all of them. Sections
+// with more than a few entries get a hash index on the first lookup, the entries themselves
+// stay in one contiguous vector. Every non-const member (adding, removing, non-const access)
+// invalidates the index; call reindex() only after renaming a key through a reference or
+// iterator obtained before the last lookup.
+class OrderedEntries : public detail::IndexedVector<std::pair<std::string, Value>> {
+   public:
+    using detail::IndexedVector<std::pair<std::string, Value>>::IndexedVector;
+
+    // the non-const overload hands out the entry, so it counts as a change
+    iterator find(std::string_view key) {
+        size_t pos = position(key);
+        touch();
+        return base::begin() + pos;
+    }
+    const_iterator find(std::string_view key) const { return begin() + position(key); }
+
+   private:
+    size_t position(std::string_view key) const {
+        return IndexedVector::position(key, [](const value_type& item) { return std::string_view(item.first); });
+    }
+};
+
+// Values of a list section, in file order. contains() goes through a hash index of the values,
+// built for lists of more than a few items (see OrderedEntries for when it is rebuilt). decode()
+// converts the whole list at once.
+class ListEntries : public detail::IndexedVector<Value> {
+   public:
+    using detail::IndexedVector<Value>::IndexedVector;
+
+    bool contains(std::string_view item) const {
+        return position(item, [](const Value& v) { return std::string_view(v.value); }) != size();
+    }
+
+    // Converts every item with Value::tryAs<T>() into 'out', plain integers take a faster path.
+    // Returns the position of the first item that does not convert, size() if all do.
+    template <class T>
+    size_t decode(std::vector<T>& out) const {
+        out.resize(size());
+        for (size_t i = 0; i < size(); ++i) {
+            const Value& item = (*this)[i];
+            if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+                long long n;
+                if (detail::parseDigits(item.value, n) &&
+                    (n < 0 ? std::is_signed_v<T> && n >= static_cast<long long>(std::numeric_limits<T>::min())
+                           : static_cast<unsigned long long>(n) <= std::numeric_limits<T>::max())) {
+                    out[i] = static_cast<T>(n);
+                    continue;
+                }
+            }
+            T res;
+            if (!item.tryAs(res)) return i;
+            out[i] = res;
+        }
+        return size();
+    }
+};
+
+// Section containers. Since 2.0 they are no longer plain std::unordered_map / std::vector:
+// unordered sections search with string_view keys and allocate from the config's memory
+// resource, ordered and list sections are vectors with an index. Code that named the 1.x types
+// should use these typedefs or auto.
+typedef std::pmr::unordered_map<std::string, Value, StringHash, std::equal_to<>> unordered_container;
+typedef OrderedEntries ordered_container;
+typedef ListEntries list_container;
+template <class Section>
+using section_map = std::pmr::unordered_map<std::string, Section, StringHash, std::equal_to<>>;
+
+namespace detail {
+
+// heterogeneous find, falls back to a temporary key without C++20 library support
+template <class Map>
+auto find(Map& map, std::string_view key) {
+#if __cpp_lib_generic_unordered_lookup
+    return map.find(key);
+#else
+    return map.find(std::string(key));
+#endif
+}
+
+// Heap allocations made for one config, counted on their way to the upstream resource.
+class CountingResource : public std::pmr::memory_resource {
+   public:
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> bytes{0};
+    std::atomic<size_t> liveBytes{0};
+
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) : upstream(upstream) {}
+
+   private:
+    std::pmr::memory_resource* upstream;
+
+    void* do_allocate(size_t size, size_t alignment) override {
+        void* res = upstream->allocate(size, alignment);
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        liveBytes.fetch_add(size, std::memory_order_relaxed);
+        return res;
+    }
+    void do_deallocate(void* p, size_t size, size_t alignment) override {
+        liveBytes.fetch_sub(size, std::memory_order_relaxed);
+        upstream->deallocate(p, size, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+}  // namespace detail
+
+// What loading a config cost, recorded with Options::stats.
+struct LoadStats {
+    struct File {
+        fs::path path;
+        uintmax_t bytes = 0;
+        int lines = 0;
+        // reading and tokenizing, 0 for files that were not read by this load (reused)
+        std::chrono::nanoseconds parseTime{0};
+        int depth = 0;  // 0 for the files given to the constructor
+        int includes = 0;
+        // Tokenized before: by an earlier include of the same file, by the config being
+        // refreshed (Options::incremental) or by another config (Options::processCache)
+        bool reused = false;
+    };
+    struct Section {
+        SectionType type;
+        std::string name;
+        size_t entries;  // entries or list items, 0 for sections Options::lazy did not tokenize yet
+    };
+
+    // every file visited in load order, like getParsedFileNames()
+    std::vector<File> files;
+    std::vector<Section> sections;
+    // Keys of unordered sections and whole ordered and list sections a file replaced in what it
+    // includes or what was loaded before it. Options::lazy counts only ordered and list sections.
+    size_t overrides = 0;
+    // reading and tokenizing all files (with threads: until the last one was ready), merging
+    std::chrono::nanoseconds parseTime{0};
+    std::chrono::nanoseconds mergeTime{0};
+    // Heap allocations through the config's memory resource while loading: section maps, nodes
+    // and vectors, of the config and of the files merged into it. Strings longer than the small
+    // buffer use the global heap and are only part of memoryBytes.
+    size_t allocations = 0;
+    size_t allocatedBytes = 0;
+    // estimate of the memory the loaded config holds, strings included
+    size_t memoryBytes = 0;
+};
+
+struct Options {
+    std::string delimiter = defaultDelimiter;
+    // Threads used to read and tokenize files, by default everything is parsed on the calling
+    // thread. 0 picks one per config file given to the constructor (up to the number of cores,
+    // all of them for a file big enough to be sharded). Sections are merged in the same order
+    // whatever the number of threads.
+    unsigned threads = 1;
+    // With more than one thread, files of at least two shardSize bytes are cut at section headers
+    // into pieces of about this size that are tokenized in parallel. 0 disables it.
+    size_t shardSize = 16 << 20;
+    // Keep the tokenized sections of every file so that refresh() only reads the files that
+    // changed. Costs about as much memory again as the loaded config.
+    bool incremental = false;
+    // Share parsed files between the configs of this process, a file that did not change since
+    // it was read by another config is not read again. Within one load every file is read once.
+    bool processCache = false;
+    // Loading only finds where the sections are, a section is tokenized when it is first used.
+    // The text of the files is copied into the config at load time, so later edits of the files
+    // (also in place) do not change what the sections are tokenized from.
+    bool lazy = false;
+    // Threads opening and reading files ahead of the parser, 0 reads every file on the thread that
+    // tokenizes it. A file read is searched for !include lines at once and the files they name are
+    // read while it is tokenized.
+    unsigned ioThreads = 0;
+    // Record LoadStats, available from _Config::getLoadStats() and passed to onStats after
+    // every load or refresh. Without it nothing is measured.
+    bool stats = false;
+    std::function<void(const LoadStats&)> onStats = nullptr;
+};
+
+// how _Config::dump() writes the config
+struct DumpOptions {
+    // between keys and values, empty for the delimiter the config was loaded with
+    std::string delimiter;
+    // Sections by name and the entries of unordered sections by key, so that equal configs
+    // give equal text. Ordered and list sections keep their order, it is part of their value.
+    bool sorted = false;
+};
 namespace errhandle {
 struct StackFrame {
     fs::path file;
@@ -77,6 +890,156 @@ struct StackFrame {
 
 using StackTrace = std::deque<StackFrame>;
 }  // namespace errhandle
+namespace scan {
+
+// Byte scanning kernels used by the tokenizer. The widest implementation supported by the
+// CPU (AVX2, SSE2 or plain scalar) is picked once at startup.
+
+struct LineScan {
+    size_t begin;      // first byte of the line after leading '\r' and ' '
+    size_t end;        // end of the line without trailing '\r'
+    size_t next;       // first byte of the next line
+    size_t delimiter;  // first delimiter occurrence inside [begin, end) or npos
+};
+
+namespace detail {
+
+// Every kernel returns the position of the first '\n' at or after 'pos' (or 'size' if there is none)
+// and stores the first occurrence of 'token' starting before that position into 'found'.
+// With 'newlines' == false line breaks are ignored and the kernel stops as soon as 'token' is found.
+using Kernel = size_t (*)(const char* data, size_t size, size_t pos, std::string_view token, bool newlines, size_t* found);
+
+inline size_t newlineFrom(const char* data, size_t size, size_t pos, bool newlines) {
+    if (!newlines || pos >= size) return size;
+    const void* nl = memchr(data + pos, '\n', size - pos);
+    return nl ? static_cast<const char*>(nl) - data : size;
+}
+
+inline size_t kernelScalar(const char* data, size_t size, size_t pos, std::string_view token, bool newlines, size_t* found) {
+    size_t nl = newlineFrom(data, size, pos, newlines);
+    size_t res = std::string_view(data + pos, nl - pos).find(token);
+    *found = res == std::string_view::npos ? res : pos + res;
+    return nl;
+}
+
+#if CFGPARSER_HAS_X86_SIMD
+
+// candidates are positions where both the first and the last byte of the token match,
+// the bytes in between are verified with memcmp
+inline bool tokenAt(const char* p, std::string_view token) {
+    return token.length() <= 2 || memcmp(p + 1, token.data() + 1, token.length() - 2) == 0;
+}
+
+__attribute__((target("avx2"))) inline size_t kernelAvx2(
+    const char* data, size_t size, size_t pos, std::string_view token, bool newlines, size_t* found
+) {
+    *found = std::string_view::npos;
+    if (token.empty()) {
+        *found = pos;
+        return newlineFrom(data, size, pos, newlines);
+    }
+    const size_t last = token.length() - 1;
+    const __m256i nlv = _mm256_set1_epi8('\n');
+    const __m256i firstv = _mm256_set1_epi8(token.front());
+    const __m256i lastv = _mm256_set1_epi8(token.back());
+    for (; pos + 32 + last <= size; pos += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + last));
+        uint32_t nl = newlines ? _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, nlv)) : 0;
+        uint32_t cand = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block, firstv), _mm256_cmpeq_epi8(tail, lastv))
+        );
+        if (nl) cand &= (nl & -nl) - 1;
+        for (; cand; cand &= cand - 1) {
+            size_t i = pos + __builtin_ctz(cand);
+            if (tokenAt(data + i, token)) {
+                *found = i;
+                return nl ? pos + __builtin_ctz(nl) : newlineFrom(data, size, i, newlines);
+            }
+        }
+        if (nl) return pos + __builtin_ctz(nl);
+    }
+    return kernelScalar(data, size, pos, token, newlines, found);
+}
+
+inline size_t kernelSse2(const char* data, size_t size, size_t pos, std::string_view token, bool newlines, size_t* found) {
+    *found = std::string_view::npos;
+    if (token.empty()) {
+        *found = pos;
+        return newlineFrom(data, size, pos, newlines);
+    }
+    const size_t last = token.length() - 1;
+    const __m128i nlv = _mm_set1_epi8('\n');
+    const __m128i firstv = _mm_set1_epi8(token.front());
+    const __m128i lastv = _mm_set1_epi8(token.back());
+    for (; pos + 16 + last <= size; pos += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + last));
+        uint32_t nl = newlines ? _mm_movemask_epi8(_mm_cmpeq_epi8(block, nlv)) : 0;
+        uint32_t cand = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block, firstv), _mm_cmpeq_epi8(tail, lastv)));
+        if (nl) cand &= (nl & -nl) - 1;
+        for (; cand; cand &= cand - 1) {
+            size_t i = pos + __builtin_ctz(cand);
+            if (tokenAt(data + i, token)) {
+                *found = i;
+                return nl ? pos + __builtin_ctz(nl) : newlineFrom(data, size, i, newlines);
+            }
+        }
+        if (nl) return pos + __builtin_ctz(nl);
+    }
+    return kernelScalar(data, size, pos, token, newlines, found);
+}
+
+#endif  // CFGPARSER_HAS_X86_SIMD
+
+inline Kernel selectKernel() {
+#if CFGPARSER_HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return kernelAvx2;
+    return kernelSse2;
+#else
+    return kernelScalar;
+#endif
+}
+
+inline const Kernel kernel = selectKernel();
+
+}  // namespace detail
+
+// position of the first occurrence of 'token' in 's' at or after 'pos', npos if there is none
+inline size_t find(std::string_view s, std::string_view token, size_t pos = 0) {
+    if (pos > s.length()) return std::string_view::npos;
+    size_t found;
+    detail::kernel(s.data(), s.length(), pos, token, false, &found);
+    return found;
+}
+
+// Splits off the line starting at 'pos' in one pass: locates its end, strips '\r' and leading
+// spaces the same way the parser does and finds the first 'delimiter' inside what is left.
+inline LineScan scanLine(std::string_view text, size_t pos, std::string_view delimiter) {
+    const char* data = text.data();
+    const size_t size = text.length();
+    LineScan res;
+
+    res.begin = pos;
+    while (res.begin < size && data[res.begin] == '\r') ++res.begin;
+    while (res.begin < size && data[res.begin] == ' ') ++res.begin;
+
+    size_t found;
+    size_t nl = res.begin < size && data[res.begin] != '\n'
+                    ? detail::kernel(data, size, res.begin, delimiter, true, &found)
+                    : (found = std::string_view::npos, std::min(res.begin, size));
+    res.next = nl < size ? nl + 1 : size;
+
+    res.end = nl;
+    while (res.end > res.begin && data[res.end - 1] == '\r') --res.end;
+
+    res.delimiter = found != std::string_view::npos && found + delimiter.length() <= res.end ? found : std::string_view::npos;
+    return res;
+}
+
+}  // namespace scan
+
 namespace strutils {
 
 inline std::vector<std::string> split(
@@ -84,27 +1047,18 @@ inline std::vector<std::string> split(
 ) {
     std::vector<std::string> res;
     if (s.empty()) return res;
-    std::string buf = "";
-    std::string delimbuf = "";
-    int j = 0;
-    for (int i = 0; i < s.length(); ++i) {
-        if (s[i] != delimiter[j]) {
-            buf.append(delimbuf);
-            delimbuf.clear();
-            buf.push_back(s[i]);
-        } else {
-            ++j;
-            delimbuf.push_back(s[i]);
-            if (j == delimiter.length()) {
-                if (!dropEmptyTokens || !buf.empty()) res.push_back(buf);
-                buf.clear();
-                j = 0;
-                delimbuf.clear();
-            }
-        }
+    if (delimiter.empty()) {
+        res.push_back(s);
+        return res;
+    }
+    size_t pos = 0;
+    while (true) {
+        size_t next = scan::find(s, delimiter, pos);
+        size_t end = next == std::string::npos ? s.length() : next;
+        if (!dropEmptyTokens || end > pos) res.emplace_back(s, pos, end - pos);
+        if (next == std::string::npos) break;
+        pos = next + delimiter.length();
     }
-    if (!buf.empty() || (!dropEmptyTokens && s.substr(s.length() - delimiter.length()) == delimiter))
-        res.push_back(buf);
     return res;
 }
 
@@ -144,120 +1098,1895 @@ inline std::string trim(const std::string& s, char symbol = ' ') {
     return res;
 }
 
-inline bool startsWith(const std::string& s, char ch) { return s.length() > 0 && s[0] == ch; }
-inline bool startsWith(const std::string& s, const std::string& token) {
-    if (s.length() < token.length()) return false;
-    for (int i = 0; i < token.length(); ++i) {
-        if (s[i] != token[i]) return false;
-    }
-    return true;
+// non-copying versions of trimLeft/trimRight/trim, the result points into 's'
+inline std::string_view trimLeftView(std::string_view s, char symbol = ' ') {
+    size_t l = 0;
+    while (l < s.length() && s[l] == symbol) ++l;
+    return s.substr(l);
 }
-inline bool endsWith(const std::string& s, char ch) { return s.length() > 0 && s[s.length() - 1] == ch; }
-inline bool endsWith(const std::string& s, const std::string& token) {
-    if (s.length() < token.length()) return false;
-    for (int i = 1; i <= token.length(); ++i) {
-        if (token[token.length() - i] != s[s.length() - i]) return false;
+inline std::string_view trimRightView(std::string_view s, char symbol = ' ') {
+    size_t r = s.length();
+    while (r > 0 && s[r - 1] == symbol) --r;
+    return s.substr(0, r);
+}
+inline std::string_view trimView(std::string_view s, char symbol = ' ') {
+    return trimRightView(trimLeftView(s, symbol), symbol);
+}
+
+inline bool startsWith(std::string_view s, char ch) { return s.length() > 0 && s[0] == ch; }
+inline bool startsWith(std::string_view s, std::string_view token) {
+    return s.length() >= token.length() && s.compare(0, token.length(), token) == 0;
+}
+inline bool endsWith(std::string_view s, char ch) { return s.length() > 0 && s[s.length() - 1] == ch; }
+inline bool endsWith(std::string_view s, std::string_view token) {
+    return s.length() >= token.length() && s.compare(s.length() - token.length(), token.length(), token) == 0;
+}
+
+template <class Container>
+std::string entriesToString(const Container& container, const std::string& delimiter) {
+    size_t size = 0;
+    for (const auto& [key, value] : container) size += key.length() + delimiter.length() + value.value.length() + 1;
+    std::string res;
+    res.reserve(size);
+    for (const auto& [key, value] : container) {
+        res.append(key).append(delimiter).append(value.value) += '\n';
     }
-    return true;
+    return res;
 }
 
 inline std::string to_string(const unordered_container& container, const std::string& delimiter = defaultDelimiter) {
-    std::stringstream ss;
-    for (auto it = container.begin(); it != container.end(); ++it) {
-        ss << it->first << delimiter << it->second.value << std::endl;
-    }
-    return ss.str();
+    return entriesToString(container, delimiter);
 }
 inline std::string to_string(const ordered_container& container, const std::string& delimiter = defaultDelimiter) {
-    std::stringstream ss;
-    for (auto it = container.begin(); it != container.end(); ++it) {
-        ss << it->first << delimiter << it->second.value << std::endl;
-    }
-    return ss.str();
+    return entriesToString(container, delimiter);
 }
-inline std::string to_string(const list_container& container, const std::string& delimiter = defaultDelimiter) {
-    std::stringstream ss;
-    for (auto it = container.begin(); it != container.end(); ++it) {
-        ss << it->value << std::endl;
-    }
-    return ss.str();
+inline std::string to_string(const list_container& container, const std::string& = defaultDelimiter) {
+    size_t size = 0;
+    for (const Value& item : container) size += item.value.length() + 1;
+    std::string res;
+    res.reserve(size);
+    for (const Value& item : container) res.append(item.value) += '\n';
+    return res;
 }
 
-}  // namespace strutils
+}  // namespace strutils
+
+namespace io {
+
+// Identity of a file version: modification time, size and inode. A file that was rewritten
+// or replaced gets a different fingerprint.
+struct Fingerprint {
+    int64_t mtime = 0;  // nanoseconds
+    uintmax_t size = 0;
+    uintmax_t inode = 0;
+    bool exists = false;
+
+    bool operator==(const Fingerprint& other) const {
+        return exists == other.exists && mtime == other.mtime && size == other.size && inode == other.inode;
+    }
+    bool operator!=(const Fingerprint& other) const { return !(*this == other); }
+
+#if CFGPARSER_HAS_MMAP
+    static Fingerprint of(const struct stat& st) {
+#if defined(__APPLE__)
+        const struct timespec& ts = st.st_mtimespec;
+#else
+        const struct timespec& ts = st.st_mtim;
+#endif
+        return Fingerprint{
+            .mtime = int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec,
+            .size = uintmax_t(st.st_size),
+            .inode = uintmax_t(st.st_ino),
+            .exists = true
+        };
+    }
+#endif
+
+    static Fingerprint of(const fs::path& path) {
+#if CFGPARSER_HAS_MMAP
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0) return Fingerprint();
+        return of(st);
+#else
+        std::error_code ec;
+        auto mtime = fs::last_write_time(path, ec);
+        if (ec) return Fingerprint();
+        uintmax_t size = fs::file_size(path, ec);
+        if (ec) return Fingerprint();
+        return Fingerprint{
+            .mtime = int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count()),
+            .size = size,
+            .exists = true
+        };
+#endif
+    }
+};
+
+// Read-only contents of a whole file. Regular files are mmap'ed unless 'map' is false,
+// everything else (pipes, platforms without mmap) is read into an owned buffer. A mapping shows
+// later changes to the file and faults on pages a truncation removed, so buffers that outlive
+// the load must not be mapped.
+class FileBuffer {
+   public:
+    explicit FileBuffer(const fs::path& path, bool map = true) {
+#if CFGPARSER_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) fail(path);
+        struct stat st;
+        int statRes = ::fstat(fd, &st);
+        if (statRes != 0 || S_ISDIR(st.st_mode)) {
+            int err = statRes != 0 ? errno : EISDIR;
+            ::close(fd);
+            errno = err;
+            fail(path);
+        }
+        stamp = Fingerprint::of(st);
+        if (map && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(addr);
+                size = st.st_size;
+                mapped = true;
+                ::close(fd);
+                return;
+            }
+        }
+        if (S_ISREG(st.st_mode)) buffer.reserve(st.st_size);
+        char chunk[1 << 16];
+        ssize_t n;
+        while ((n = ::read(fd, chunk, sizeof(chunk))) != 0) {
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                int err = errno;
+                ::close(fd);
+                errno = err;
+                fail(path);
+            }
+            buffer.append(chunk, n);
+        }
+        ::close(fd);
+#else
+        std::ifstream file(path, std::ios::binary);
+        if (file.fail()) fail(path);
+        stamp = Fingerprint::of(path);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        buffer = ss.str();
+#endif
+        data = buffer.data();
+        size = buffer.size();
+    }
+
+    FileBuffer(const FileBuffer&) = delete;
+    FileBuffer& operator=(const FileBuffer&) = delete;
+
+    ~FileBuffer() {
+#if CFGPARSER_HAS_MMAP
+        if (mapped) ::munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+    std::string_view view() const { return std::string_view(data, size); }
+    // asks the kernel to start reading all of a mapped file in the background
+    void willNeed() const {
+#if CFGPARSER_HAS_MMAP
+        if (mapped) ::madvise(const_cast<char*>(data), size, MADV_WILLNEED);
+#endif
+    }
+    // taken when the file was opened
+    const Fingerprint& fingerprint() const { return stamp; }
+
+   private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    std::string buffer;
+    Fingerprint stamp;
+
+    [[noreturn]] static void fail(const fs::path& path) {
+        throw std::runtime_error("can not open file '" + path.string() + "': " + std::string(strerror(errno)));
+    }
+};
+
+}  // namespace io
+
+namespace detail {
+
+// Fixed set of workers running tasks in FIFO order. Tasks still queued when the pool is stopped
+// or destroyed are dropped.
+class ThreadPool {
+   public:
+    explicit ThreadPool(unsigned threads) {
+        for (unsigned i = 0; i < threads; ++i) workers.emplace_back([this] { run(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() { stop(); }
+
+    // waits for the running tasks, tasks posted later are dropped
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+        wakeup.notify_all();
+        for (std::thread& worker : workers) worker.join();
+        workers.clear();
+    }
+
+    void post(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopped) return;
+            tasks.push_back(std::move(task));
+        }
+        wakeup.notify_one();
+    }
+
+   private:
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<std::function<void()>> tasks;
+    bool stopped = false;
+    std::vector<std::thread> workers;
+
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeup.wait(lock, [this] { return stopped || !tasks.empty(); });
+                if (stopped) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+}  // namespace detail
+
+namespace phf {
+
+// Minimal perfect hashing (hash-and-displace with per-bucket pilots, PTHash style) over a fixed
+// set of 64-bit key hashes. Every key gets a distinct slot in [0, size); a lookup costs one pilot
+// load and one slot computation.
+
+inline uint64_t fmix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint64_t hash(std::string_view s, uint64_t seed) {
+    uint64_t h = seed ^ (s.length() * 0x9e3779b97f4a7c15ULL);
+    size_t i = 0;
+    for (; i + 8 <= s.length(); i += 8) {
+        uint64_t word;
+        memcpy(&word, s.data() + i, 8);
+        h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+        h = (h << 31) | (h >> 33);
+    }
+    uint64_t word = 0;
+    memcpy(&word, s.data() + i, s.length() - i);
+    return fmix(h ^ word);
+}
+
+// hash of a (section type, section) pair
+inline uint64_t hash(SectionType type, std::string_view section, uint64_t seed) { return hash(section, seed + type); }
+
+// hash of a (section type, section, key) triple
+inline uint64_t hash(SectionType type, std::string_view section, std::string_view key, uint64_t seed) {
+    return hash(key, hash(type, section, seed));
+}
+
+struct Table {
+    uint64_t seed = 0;
+    uint64_t size = 0;       // number of keys and slots
+    uint64_t tableSize = 0;  // slots addressed by pilots, the ones past 'size' are remapped
+    std::vector<uint32_t> pilots;
+    std::vector<uint32_t> remap;
+
+    size_t slot(uint64_t h) const { return slot(h, pilots.data(), pilots.size(), size, tableSize, remap.data()); }
+
+    // same as above for a table stored elsewhere (see image::TableRef)
+    static size_t slot(
+        uint64_t h, const uint32_t* pilots, size_t pilotCount, uint64_t size, uint64_t tableSize, const uint32_t* remap
+    ) {
+        uint64_t pilot = pilots[h % pilotCount];
+        uint64_t s = fmix(h ^ (pilot * 0x9e3779b97f4a7c15ULL + 1)) % tableSize;
+        return s < size ? s : remap[s - size];
+    }
+
+    // 'hashOf(i, seed)' returns the hash of the i-th key, the seed changes if the build has to be retried
+    template <class HashOf>
+    static Table build(size_t n, HashOf&& hashOf) {
+        Table table;
+        table.size = n;
+        if (n == 0) return table;
+        std::vector<uint64_t> hashes(n);
+        for (uint64_t seed = 0;; ++seed) {
+            table.seed = seed;
+            for (size_t i = 0; i < n; ++i) hashes[i] = hashOf(i, seed);
+            if (table.place(hashes)) return table;
+        }
+    }
+
+   private:
+    bool place(const std::vector<uint64_t>& hashes) {
+        const size_t n = hashes.size();
+        // keys with equal hashes can never be separated
+        std::vector<uint64_t> sorted(hashes);
+        std::sort(sorted.begin(), sorted.end());
+        if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) return false;
+
+        tableSize = n + n / 16 + 1;
+        pilots.assign(std::max<size_t>(1, n / 3), 0);
+
+        // keys grouped by bucket, largest buckets are placed first
+        std::vector<uint32_t> bucketStart(pilots.size() + 1, 0);
+        for (uint64_t h : hashes) ++bucketStart[h % pilots.size() + 1];
+        for (size_t b = 0; b < pilots.size(); ++b) bucketStart[b + 1] += bucketStart[b];
+        std::vector<uint64_t> byBucket(n);
+        std::vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+        for (uint64_t h : hashes) byBucket[fill[h % pilots.size()]++] = h;
+        std::vector<uint32_t> order(pilots.size());
+        for (size_t b = 0; b < order.size(); ++b) order[b] = b;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+        });
+
+        std::vector<bool> taken(tableSize, false);
+        std::vector<uint64_t> slots;
+        for (uint32_t b : order) {
+            size_t begin = bucketStart[b], end = bucketStart[b + 1];
+            if (begin == end) break;
+            bool placed = false;
+            for (uint32_t pilot = 0; pilot < (1u << 20) && !placed; ++pilot) {
+                slots.clear();
+                placed = true;
+                for (size_t i = begin; i < end && placed; ++i) {
+                    uint64_t s = fmix(byBucket[i] ^ (pilot * 0x9e3779b97f4a7c15ULL + 1)) % tableSize;
+                    placed = !taken[s] && std::find(slots.begin(), slots.end(), s) == slots.end();
+                    slots.push_back(s);
+                }
+                if (placed) {
+                    pilots[b] = pilot;
+                    for (uint64_t s : slots) taken[s] = true;
+                }
+            }
+            if (!placed) return false;
+        }
+
+        // slots past 'size' are moved into the holes below it
+        remap.assign(tableSize - n, 0);
+        size_t hole = 0;
+        for (size_t s = n; s < tableSize; ++s) {
+            if (!taken[s]) continue;
+            while (taken[hole]) ++hole;
+            remap[s - n] = hole++;
+        }
+        return true;
+    }
+};
+
+}  // namespace phf
+
+// Read-only snapshot of a config. Unordered and ordered entries are compiled into one flat table
+// indexed by a minimal perfect hash of (section, key), so a lookup is one probe and one compare.
+// Nothing is modified after construction, a snapshot can be shared between threads freely.
+// Unordered entries with the same value share one Value, so two find() results with the same text
+// are the same pointer and a value is converted once however many keys hold it. Only the
+// snapshot interns, the _Config it is frozen from keeps a string per key and value.
+class FrozenConfig {
+   public:
+    FrozenConfig(
+        const section_map<unordered_container>& unorderedSections,
+        const section_map<ordered_container>& orderedSections,
+        const section_map<list_container>& listSections
+    )
+        : orderedSections(orderedSections.begin(), orderedSections.end()),
+          listSections(listSections.begin(), listSections.end()) {
+        struct Source {
+            SectionType type;
+            const std::string* section;
+            const std::string* key;
+            const Value* value;
+        };
+        std::vector<Source> sources;
+        // every distinct section name and key is stored once, by offset in 'text'
+        std::unordered_map<std::string_view, size_t> offsets;
+        // every distinct value of an unordered section once, by position in 'values'
+        std::unordered_map<std::string_view, size_t> valuePositions;
+        size_t textSize = 0;
+        auto intern = [&](std::string_view s) {
+            if (offsets.try_emplace(s, textSize).second) textSize += s.length();
+        };
+        for (const auto& [name, section] : unorderedSections) {
+            sectionNames.push_back(name);
+            if (!section.empty()) intern(name);
+            for (const auto& [key, value] : section) {
+                sources.push_back({UNORDERED, &name, &key, &value});
+                intern(key);
+                valuePositions.try_emplace(value.value, valuePositions.size());
+            }
+        }
+        std::sort(sectionNames.begin(), sectionNames.end());
+        // ordered entries point at the values of the copied sections
+        for (const auto& [name, section] : this->orderedSections) {
+            // the first occurrence of a key wins, like in getOrdered()
+            std::unordered_map<std::string_view, bool> seen;
+            if (!section.empty()) intern(name);
+            for (const auto& [key, value] : section) {
+                if (!seen.emplace(key, true).second) continue;
+                sources.push_back({ORDERED, &name, &key, &value});
+                intern(key);
+            }
+        }
+        values.resize(valuePositions.size());
+        for (const auto& [value, position] : valuePositions) values[position] = Value(std::string(value));
+
+        table = phf::Table::build(sources.size(), [&](size_t i, uint64_t seed) {
+            return phf::hash(sources[i].type, *sources[i].section, *sources[i].key, seed);
+        });
+
+        text.resize(textSize);
+        for (const auto& [s, offset] : offsets) memcpy(text.data() + offset, s.data(), s.length());
+        auto store = [&](const std::string& s) { return std::string_view(text.data() + offsets.find(s)->second, s.length()); };
+
+        entries.resize(sources.size());
+        for (const Source& src : sources) {
+            uint64_t h = phf::hash(src.type, *src.section, *src.key, table.seed);
+            Entry& entry = entries[table.slot(h)];
+            entry.hash = h;
+            entry.type = src.type;
+            entry.section = store(*src.section);
+            entry.key = store(*src.key);
+            entry.value = src.type == ORDERED ? src.value : &values[valuePositions.find(src.value->value)->second];
+        }
+    }
+
+    FrozenConfig(const FrozenConfig&) = delete;
+    FrozenConfig& operator=(const FrozenConfig&) = delete;
+
+    // nullptr if there is no such key
+    const Value* find(std::string_view section, std::string_view key) const { return lookup(UNORDERED, section, key); }
+    const Value* findOrdered(std::string_view section, std::string_view key) const {
+        return lookup(ORDERED, section, key);
+    }
+
+    bool contains(std::string_view name) const { return contains("", name); }
+    bool contains(std::string_view section, std::string_view name) const { return find(section, name) != nullptr; }
+
+    const Value& get(std::string_view key) const { return get("", key); }
+    const Value& get(std::string_view section, std::string_view key) const {
+        if (const Value* value = find(section, key)) return *value;
+        if (!std::binary_search(sectionNames.begin(), sectionNames.end(), section))
+            throw std::runtime_error("No such unordered section '" + std::string(section) + "'");
+        throw std::runtime_error("'" + std::string(key) + "' not found in unordered section '" + std::string(section) + "'");
+    }
+
+    const ordered_container* findOrderedSection(std::string_view section) const {
+        auto it = detail::find(orderedSections, section);
+        return it == orderedSections.end() ? nullptr : &it->second;
+    }
+    const list_container* findList(std::string_view name) const {
+        auto it = detail::find(listSections, name);
+        return it == listSections.end() ? nullptr : &it->second;
+    }
+
+    const Value& getOrdered(std::string_view section, std::string_view key) const {
+        if (const Value* value = findOrdered(section, key)) return *value;
+        getOrderedSection(section);
+        throw std::runtime_error("'" + std::string(key) + "' not found in ordered section '" + std::string(section) + "'");
+    }
+    const ordered_container& getOrderedSection(std::string_view section) const {
+        const ordered_container* res = findOrderedSection(section);
+        if (!res) throw std::runtime_error("No such ordered section '" + std::string(section) + "'");
+        return *res;
+    }
+    const list_container& getList(std::string_view name) const {
+        const list_container* res = findList(name);
+        if (!res) throw std::runtime_error("No such list section '" + std::string(name) + "'");
+        return *res;
+    }
+
+    // number of entries in the lookup table
+    size_t size() const { return entries.size(); }
+
+   private:
+    struct Entry {
+        uint64_t hash = 0;
+        SectionType type = UNORDERED;
+        std::string_view section;
+        std::string_view key;
+        const Value* value = nullptr;  // into 'values' or 'orderedSections'
+    };
+
+    phf::Table table;
+    std::vector<Entry> entries;
+    // distinct section names and keys referenced by the entries, never reallocated after construction
+    std::vector<char> text;
+    // distinct values of the unordered entries, never reallocated after construction
+    std::vector<Value> values;
+    std::vector<std::string> sectionNames;
+    std::unordered_map<std::string, ordered_container, StringHash, std::equal_to<>> orderedSections;
+    std::unordered_map<std::string, list_container, StringHash, std::equal_to<>> listSections;
+
+    const Value* lookup(SectionType type, std::string_view section, std::string_view key) const {
+        if (entries.empty()) return nullptr;
+        uint64_t h = phf::hash(type, section, key, table.seed);
+        const Entry& entry = entries[table.slot(h)];
+        if (entry.hash != h || entry.type != type || entry.key != key || entry.section != section) return nullptr;
+        return entry.value;
+    }
+};
+
+// Compiled config image: the merged sections of a config together with precomputed hash tables,
+// laid out so that CompiledConfig answers lookups straight from a read-only mapping of the file.
+//
+//   Header | entry table | section table | items | strings
+//
+// A table is the pilots and remap arrays of a phf::Table followed by its records in slot order.
+// Numbers are stored in the byte order of the writer, every array starts 8-byte aligned.
+namespace image {
+
+constexpr char magic[8] = {'C', 'F', 'G', 'I', 'M', 'A', 'G', 'E'};
+constexpr uint32_t version = 1;
+constexpr uint32_t byteOrderMark = 0x01020304;
+
+struct StringRef {
+    uint64_t offset;  // into the string area
+    uint64_t length;
+};
+
+struct TableRef {
+    uint64_t seed;
+    uint64_t size;
+    uint64_t tableSize;
+    uint64_t pilotCount;
+    uint64_t pilots;   // file offset of uint32_t[pilotCount]
+    uint64_t remap;    // file offset of uint32_t[tableSize - size]
+    uint64_t records;  // file offset of the records
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+    uint64_t checksum;  // phf::hash() of everything after the header, seed 0
+    TableRef entries;   // Entry by (type, section, key), unordered and ordered sections
+    TableRef sections;  // Section by (type, name), all sections
+    uint64_t items;     // file offset of Item[itemCount]
+    uint64_t itemCount;
+    uint64_t strings;   // file offset of the string area
+    uint64_t stringsSize;
+};
+
+struct Entry {
+    uint64_t hash;
+    uint64_t type;
+    StringRef section;
+    StringRef key;
+    StringRef value;
+};
+
+struct Section {
+    uint64_t hash;
+    uint64_t type;
+    StringRef name;
+    uint64_t first;  // items of an ordered or list section are [first, first + count)
+    uint64_t count;
+};
+
+// key is empty for list items
+struct Item {
+    StringRef key;
+    StringRef value;
+};
+
+namespace detail {
+
+inline uint64_t align(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+template <class Record>
+struct TableBuilder {
+    std::vector<Record> records;
+    std::function<uint64_t(const Record&, uint64_t)> hashOf;
+    phf::Table table;
+
+    void build() {
+        table = phf::Table::build(records.size(), [&](size_t i, uint64_t seed) { return hashOf(records[i], seed); });
+        std::vector<Record> placed(records.size());
+        for (Record& record : records) {
+            record.hash = hashOf(record, table.seed);
+            placed[table.slot(record.hash)] = record;
+        }
+        records = std::move(placed);
+    }
+
+    uint64_t layout(uint64_t offset, TableRef& ref) const {
+        ref.seed = table.seed;
+        ref.size = table.size;
+        ref.tableSize = table.tableSize;
+        ref.pilotCount = table.pilots.size();
+        ref.pilots = align(offset);
+        ref.remap = align(ref.pilots + table.pilots.size() * sizeof(uint32_t));
+        ref.records = align(ref.remap + table.remap.size() * sizeof(uint32_t));
+        return ref.records + records.size() * sizeof(Record);
+    }
+
+    void write(std::string& out, const TableRef& ref) const {
+        memcpy(&out[ref.pilots], table.pilots.data(), table.pilots.size() * sizeof(uint32_t));
+        memcpy(&out[ref.remap], table.remap.data(), table.remap.size() * sizeof(uint32_t));
+        memcpy(&out[ref.records], records.data(), records.size() * sizeof(Record));
+    }
+};
+
+}  // namespace detail
+
+// the image of a merged config, see _Config::compile()
+inline std::string build(
+    const section_map<unordered_container>& unorderedSections,
+    const section_map<ordered_container>& orderedSections,
+    const section_map<list_container>& listSections
+) {
+    // every distinct string is stored once, repeated keys and values share it
+    std::string strings;
+    std::unordered_map<std::string_view, StringRef> refs;
+    auto ref = [&](std::string_view s) {
+        auto [it, inserted] = refs.try_emplace(s, StringRef{strings.size(), s.length()});
+        if (inserted) strings.append(s);
+        return it->second;
+    };
+    auto view = [&](const StringRef& r) { return std::string_view(strings).substr(r.offset, r.length); };
+
+    detail::TableBuilder<Entry> entries;
+    entries.hashOf = [&](const Entry& e, uint64_t seed) {
+        return phf::hash(SectionType(e.type), view(e.section), view(e.key), seed);
+    };
+    detail::TableBuilder<Section> sections;
+    sections.hashOf = [&](const Section& s, uint64_t seed) { return phf::hash(SectionType(s.type), view(s.name), seed); };
+    std::vector<Item> items;
+
+    for (const auto& [name, section] : unorderedSections) {
+        StringRef nameRef = ref(name);
+        sections.records.push_back({0, UNORDERED, nameRef, 0, 0});
+        for (const auto& [key, value] : section) entries.records.push_back({0, UNORDERED, nameRef, ref(key), ref(value.value)});
+    }
+    for (const auto& [name, section] : orderedSections) {
+        StringRef nameRef = ref(name);
+        sections.records.push_back({0, ORDERED, nameRef, items.size(), section.size()});
+        // the first occurrence of a key wins, like in getOrdered()
+        std::unordered_map<std::string_view, bool> seen;
+        for (const auto& [key, value] : section) {
+            Item item{ref(key), ref(value.value)};
+            items.push_back(item);
+            if (seen.emplace(key, true).second) entries.records.push_back({0, ORDERED, nameRef, item.key, item.value});
+        }
+    }
+    for (const auto& [name, section] : listSections) {
+        sections.records.push_back({0, LIST, ref(name), items.size(), section.size()});
+        for (const Value& value : section) items.push_back({StringRef{0, 0}, ref(value.value)});
+    }
+    entries.build();
+    sections.build();
+
+    Header header{};
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byteOrder = byteOrderMark;
+    uint64_t end = entries.layout(sizeof(Header), header.entries);
+    end = sections.layout(end, header.sections);
+    header.items = detail::align(end);
+    header.itemCount = items.size();
+    header.strings = detail::align(header.items + items.size() * sizeof(Item));
+    header.stringsSize = strings.size();
+    header.fileSize = header.strings + strings.size();
+
+    std::string out(header.fileSize, '\0');
+    entries.write(out, header.entries);
+    sections.write(out, header.sections);
+    memcpy(&out[header.items], items.data(), items.size() * sizeof(Item));
+    memcpy(&out[header.strings], strings.data(), strings.size());
+    header.checksum = phf::hash(std::string_view(out).substr(sizeof(Header)), 0);
+    memcpy(&out[0], &header, sizeof(Header));
+    return out;
+}
+
+}  // namespace image
+
+// Loader of an image written by _Config::compile(). The file is mapped and lookups read the
+// hash tables and strings in place, so opening costs the same whatever the size of the config.
+// Returned string_views point into the mapping and live as long as the CompiledConfig.
+class CompiledConfig {
+   public:
+    // contents of an ordered section (pairs of key and value) or a list section (values)
+    template <bool IsList>
+    class SectionView {
+       public:
+        using value_type = std::conditional_t<IsList, std::string_view, std::pair<std::string_view, std::string_view>>;
+
+        class iterator {
+           public:
+            iterator(const SectionView* view, size_t i) : view(view), i(i) {}
+            value_type operator*() const { return (*view)[i]; }
+            iterator& operator++() {
+                ++i;
+                return *this;
+            }
+            bool operator==(const iterator& other) const { return i == other.i; }
+            bool operator!=(const iterator& other) const { return i != other.i; }
+
+           private:
+            const SectionView* view;
+            size_t i;
+        };
+
+        SectionView(const image::Item* items, size_t count, const CompiledConfig* config)
+            : items(items), count(count), config(config) {}
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        value_type operator[](size_t i) const {
+            if constexpr (IsList) return config->string(items[i].value);
+            else return {config->string(items[i].key), config->string(items[i].value)};
+        }
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, count); }
+
+       private:
+        const image::Item* items;
+        size_t count;
+        const CompiledConfig* config;
+    };
+    using OrderedSection = SectionView<false>;
+    using ListSection = SectionView<true>;
+
+    // Without 'verifyChecksum' only the header and table bounds are checked when opening; the
+    // checksum reads the whole file. Either way every slot, string and item range is checked
+    // against the mapping when a lookup reads it, a damaged image throws instead of reading
+    // outside the file.
+    explicit CompiledConfig(const fs::path& path, bool verifyChecksum = true) : file(path), path(path) {
+        std::string_view data = file.view();
+        auto check = [&](bool ok, const char* problem) {
+            if (!ok) corrupted(problem);
+        };
+        check(data.size() >= sizeof(image::Header), "file too short");
+        base = data.data();
+        memcpy(&header, base, sizeof(image::Header));
+        check(memcmp(header.magic, image::magic, sizeof(image::magic)) == 0, "not a config image");
+        check(header.version == image::version, "unsupported version");
+        check(header.byteOrder == image::byteOrderMark, "written with a different byte order");
+        check(header.fileSize == data.size(), "truncated");
+        check(reinterpret_cast<uintptr_t>(base) % 8 == 0, "misaligned mapping");
+        // arrays of 'count' elements of 'size' bytes, aligned for their widest field
+        auto fits = [&](uint64_t offset, uint64_t count, uint64_t size) {
+            return offset % std::min<uint64_t>(size, 8) == 0 && offset <= data.size() && count <= (data.size() - offset) / size;
+        };
+        for (const image::TableRef* t : {&header.entries, &header.sections}) {
+            check(t->tableSize >= t->size && (t->size == 0 || t->pilotCount > 0), "bad table");
+            check(fits(t->pilots, t->pilotCount, sizeof(uint32_t)), "bad table");
+            check(fits(t->remap, t->tableSize - t->size, sizeof(uint32_t)), "bad table");
+            check(fits(t->records, t->size, t == &header.entries ? sizeof(image::Entry) : sizeof(image::Section)), "bad table");
+        }
+        check(fits(header.items, header.itemCount, sizeof(image::Item)), "bad items");
+        check(fits(header.strings, header.stringsSize, 1), "bad strings");
+        if (verifyChecksum) check(phf::hash(data.substr(sizeof(image::Header)), 0) == header.checksum, "checksum mismatch");
+    }
+
+    CompiledConfig(const CompiledConfig&) = delete;
+    CompiledConfig& operator=(const CompiledConfig&) = delete;
+
+    // false if there is no such key
+    bool find(std::string_view section, std::string_view key, std::string_view& value) const {
+        return lookup(UNORDERED, section, key, value);
+    }
+    bool findOrdered(std::string_view section, std::string_view key, std::string_view& value) const {
+        return lookup(ORDERED, section, key, value);
+    }
+
+    bool contains(std::string_view name) const { return contains("", name); }
+    bool contains(std::string_view section, std::string_view name) const {
+        std::string_view value;
+        return find(section, name, value);
+    }
+
+    std::string_view get(std::string_view key) const { return get("", key); }
+    std::string_view get(std::string_view section, std::string_view key) const {
+        std::string_view value;
+        if (find(section, key, value)) return value;
+        if (!findSection(UNORDERED, section))
+            throw std::runtime_error("No such unordered section '" + std::string(section) + "'");
+        throw std::runtime_error("'" + std::string(key) + "' not found in unordered section '" + std::string(section) + "'");
+    }
+
+    std::string_view getOrdered(std::string_view section, std::string_view key) const {
+        std::string_view value;
+        if (findOrdered(section, key, value)) return value;
+        getOrderedSection(section);
+        throw std::runtime_error("'" + std::string(key) + "' not found in ordered section '" + std::string(section) + "'");
+    }
+    OrderedSection getOrderedSection(std::string_view section) const {
+        const image::Section* res = findSection(ORDERED, section);
+        if (!res) throw std::runtime_error("No such ordered section '" + std::string(section) + "'");
+        return OrderedSection(items(*res), res->count, this);
+    }
+    ListSection getList(std::string_view name) const {
+        const image::Section* res = findSection(LIST, name);
+        if (!res) throw std::runtime_error("No such list section '" + std::string(name) + "'");
+        return ListSection(items(*res), res->count, this);
+    }
+
+    // number of entries in the lookup table
+    size_t size() const { return header.entries.size; }
+
+   private:
+    io::FileBuffer file;
+    fs::path path;
+    const char* base = nullptr;
+    image::Header header;
+
+    [[noreturn]] void corrupted(const char* problem) const {
+        throw std::runtime_error("Config image '" + path.string() + "': " + problem);
+    }
+
+    template <class T>
+    const T* at(uint64_t offset) const {
+        return reinterpret_cast<const T*>(base + offset);
+    }
+    const image::Item* items(const image::Section& section) const {
+        if (section.first > header.itemCount || section.count > header.itemCount - section.first) corrupted("bad section");
+        return at<image::Item>(header.items) + section.first;
+    }
+    std::string_view string(const image::StringRef& r) const {
+        if (r.offset > header.stringsSize || r.length > header.stringsSize - r.offset) corrupted("bad string");
+        return std::string_view(base + header.strings + r.offset, r.length);
+    }
+
+    template <class Record>
+    const Record* probe(const image::TableRef& t, uint64_t h) const {
+        if (t.size == 0) return nullptr;
+        size_t slot = phf::Table::slot(h, at<uint32_t>(t.pilots), t.pilotCount, t.size, t.tableSize, at<uint32_t>(t.remap));
+        if (slot >= t.size) corrupted("bad table");
+        const Record* record = at<Record>(t.records) + slot;
+        return record->hash == h ? record : nullptr;
+    }
+
+    bool lookup(SectionType type, std::string_view section, std::string_view key, std::string_view& value) const {
+        const image::Entry* entry = probe<image::Entry>(header.entries, phf::hash(type, section, key, header.entries.seed));
+        if (!entry || entry->type != type || string(entry->key) != key || string(entry->section) != section) return false;
+        value = string(entry->value);
+        return true;
+    }
+
+    const image::Section* findSection(SectionType type, std::string_view name) const {
+        const image::Section* res = probe<image::Section>(header.sections, phf::hash(type, name, header.sections.seed));
+        if (!res || res->type != type || string(res->name) != name) return nullptr;
+        return res;
+    }
+};
+
+// Callbacks of parseEvents(). Lines are reported in file order while they are read, the contents
+// of an included file at its '!include' line; nothing is merged or kept. Views are valid only
+// during the call. An exception thrown here stops parsing and is reported with the stack trace.
+class EventHandler {
+   public:
+    virtual ~EventHandler() = default;
+
+    // trace.back().file is the file, the frames before it are the include chain
+    virtual void fileBegin(const errhandle::StackTrace& /*trace*/) {}
+    virtual void fileEnd(const errhandle::StackTrace& /*trace*/) {}
+    // At a section header. Also before the next line of a section that continues after an
+    // '!include', and before the first line of the main section (UNORDERED, "") of a file.
+    virtual void sectionBegin(SectionType /*type*/, std::string_view /*name*/) {}
+    // at the next header, before an '!include' and at the end of the file
+    virtual void sectionEnd(SectionType /*type*/, std::string_view /*name*/) {}
+    // a line of an unordered or ordered section
+    virtual void entry(std::string_view /*key*/, std::string_view /*value*/) {}
+    // a line of a list section
+    virtual void listItem(std::string_view /*value*/) {}
+};
+
+class _Config {
+   private:
+    static fs::path make_absolute_path(const fs::path& included, const fs::path& from) {
+        if (included.is_absolute()) return included;
+        else if (from.empty()) return fs::absolute(included);
+        else return fs::absolute(from.parent_path() / included);
+    }
+
+    std::vector<fs::path> configFileNames;
+    // every file read while loading, includes too, in the order they were opened
+    std::vector<fs::path> parsedFileNames;
+    Options options;
+    std::string delimiter = defaultDelimiter;
+
+    // with Options::stats, under the sections. Files parsed for this config allocate from it
+    // too, so their sections can still be moved in by merge(), and hold on to it for as long as
+    // they are kept (Options::incremental, Options::processCache). Must be declared before the
+    // sections.
+    std::shared_ptr<detail::CountingResource> counting;
+    std::unique_ptr<LoadStats> stats;
+
+    section_map<unordered_container> unorderedSections;
+    section_map<ordered_container> orderedSections;
+    section_map<list_container> listSections;
+
+    std::pmr::memory_resource* memoryResource() {
+        return counting ? static_cast<std::pmr::memory_resource*>(counting.get()) : std::pmr::new_delete_resource();
+    }
+
+    // Sections of one file, tokenized on its own without following its includes. Includes are
+    // merged before the file's own sections, so the file always overrides what it includes.
+    struct ParsedFile {
+        struct Include {
+            fs::path path;  // as written after '!include'
+            int line_number;
+        };
+
+        // the memory resource of the config's sections, nullptr for new_delete_resource()
+        std::shared_ptr<std::pmr::memory_resource> shared;
+        section_map<unordered_container> unorderedSections;
+        section_map<ordered_container> orderedSections;
+        section_map<list_container> listSections;
+        // includes in file order, only the ones above 'error_line'
+        std::vector<Include> includes;
+
+        // set if the file could not be read (error_line == 0) or a line could not be parsed
+        std::string error;
+        int error_line = 0;
+        io::Fingerprint fingerprint;
+        size_t bytes = 0;
+        int lines = 0;
+        std::chrono::nanoseconds parseTime{0};  // with Options::stats
+
+        // Options::lazy: the sections are not tokenized, 'bodies' tells where they are in 'text'
+        struct Body {
+            SectionType type;
+            std::string name;
+            size_t begin;  // header line, the main section starts at 0
+            size_t end;
+            int first_line;  // number of lines before 'begin'
+        };
+        std::shared_ptr<const io::FileBuffer> text;
+        std::vector<Body> bodies;
+
+        explicit ParsedFile(std::shared_ptr<std::pmr::memory_resource> shared)
+            : shared(std::move(shared)),
+              unorderedSections(resource()),
+              orderedSections(resource()),
+              listSections(resource()) {}
+
+        std::pmr::memory_resource* resource() { return shared ? shared.get() : std::pmr::new_delete_resource(); }
+    };
+
+    // Tokenizer sink filling a ParsedFile. Looks a section up once at its header, not per entry.
+    class FileSink {
+       public:
+        explicit FileSink(ParsedFile& parsed) : parsed(parsed) {}
+
+        void include(std::string_view path, int line_number) { parsed.includes.push_back({fs::path(path), line_number}); }
+
+        void section(SectionType sectionType, std::string_view name) {
+            type = sectionType;
+            sectionName = name;
+            unordered = nullptr;
+            switch (type) {
+                case UNORDERED: unordered = &parsed.unorderedSections[sectionName]; break;
+                case ORDERED: ordered = &parsed.orderedSections[sectionName]; break;
+                case LIST: list = &parsed.listSections[sectionName]; break;
+            }
+        }
+
+        void entry(std::string_view key, std::string_view value) {
+            keyBuffer = key;
+            valueBuffer = value;
+            if (type == ORDERED) {
+                ordered->push_back({keyBuffer, valueBuffer});
+                return;
+            }
+            // the main section is created with its first entry
+            if (!unordered) unordered = &parsed.unorderedSections[sectionName];
+            (*unordered)[keyBuffer] = valueBuffer;
+        }
+
+        void item(std::string_view value) { list->push_back(std::string(value)); }
+
+       private:
+        ParsedFile& parsed;
+        SectionType type = UNORDERED;
+        std::string sectionName;
+        unordered_container* unordered = nullptr;
+        ordered_container* ordered = nullptr;
+        list_container* list = nullptr;
+        std::string keyBuffer, valueBuffer;
+    };
+
+    // Tokenizer sink for Options::lazy, records where sections begin and end instead of storing
+    // their lines. The lines are still checked, so a bad line is reported while loading.
+    class ScanSink {
+       public:
+        ScanSink(ParsedFile& parsed, std::string_view text, const int& line_number)
+            : parsed(parsed), text(text), line_number(line_number) {}
+
+        void include(std::string_view path, int line_number) { parsed.includes.push_back({fs::path(path), line_number}); }
+
+        void section(SectionType sectionType, std::string_view name) {
+            // 'name' points into the header line
+            size_t begin = name.data() - text.data();
+            while (begin > 0 && text[begin - 1] != '\n') --begin;
+            close(begin);
+            body = {sectionType, std::string(name), begin, 0, line_number - 1};
+            lines = false;
+        }
+
+        void entry(std::string_view, std::string_view) { lines = true; }
+        void item(std::string_view) { lines = true; }
+
+        // ends the current section at 'end', an unordered one without lines does not exist
+        void close(size_t end) {
+            body.end = end;
+            if (lines || body.type != UNORDERED) parsed.bodies.push_back(std::move(body));
+        }
+
+       private:
+        ParsedFile& parsed;
+        std::string_view text;
+        const int& line_number;
+        ParsedFile::Body body{UNORDERED, "", 0, 0, 0};
+        bool lines = false;
+    };
+
+    // Tokenizer sink for Options::lazy, fills one section from the parts of its files
+    template <class Container>
+    class BodySink {
+       public:
+        explicit BodySink(Container& target) : target(target) {}
+
+        void include(std::string_view, int) {}
+        void section(SectionType, std::string_view) {}
+
+        void entry(std::string_view key, std::string_view value) {
+            keyBuffer = key;
+            valueBuffer = value;
+            if constexpr (std::is_same_v<Container, ordered_container>) target.push_back({keyBuffer, valueBuffer});
+            else if constexpr (std::is_same_v<Container, unordered_container>) target[keyBuffer] = valueBuffer;
+        }
+
+        void item(std::string_view value) {
+            if constexpr (std::is_same_v<Container, list_container>) target.push_back(std::string(value));
+        }
+
+       private:
+        Container& target;
+        std::string keyBuffer, valueBuffer;
+    };
+
+    // Options::lazy: the parts of the files a section is made of, in merge order
+    struct LazySection {
+        struct Part {
+            std::shared_ptr<const io::FileBuffer> text;
+            size_t begin;
+            size_t end;
+            int first_line;
+        };
+        std::once_flag once;
+        std::vector<Part> parts;
+    };
+    // by section, filled while loading and not changed after that
+    std::unordered_map<const void*, LazySection> lazySections;
+
+    // Options::lazy: tokenizes the section on its first use, safe to call from several threads
+    template <class Container>
+    Container* materialize(Container* section) {
+        if (lazySections.empty()) return section;
+        auto it = lazySections.find(section);
+        if (it == lazySections.end()) return section;
+        std::call_once(it->second.once, [&] {
+            BodySink<Container> sink(*section);
+            // the text is the copy scanFile() checked, it tokenizes without errors
+            for (const LazySection::Part& part : it->second.parts) {
+                int line_number = part.first_line;
+                tokenize(part.text->view().substr(part.begin, part.end - part.begin), delimiter, line_number, sink);
+            }
+        });
+        return section;
+    }
+
+    void materializeAll() {
+        if (lazySections.empty()) return;
+        for (auto& [name, section] : unorderedSections) materialize(&section);
+        for (auto& [name, section] : orderedSections) materialize(&section);
+        for (auto& [name, section] : listSections) materialize(&section);
+    }
+
+    // Options::lazy: merge() without tokenizing, only records which parts make up each section
+    size_t mergeLazy(const ParsedFile& parsed) {
+        size_t overrides = 0;
+        // ordered and list sections of a file replace the ones of its includes
+        std::unordered_set<const void*> replaced;
+        for (const ParsedFile::Body& body : parsed.bodies) {
+            const void* section = nullptr;
+            switch (body.type) {
+                case UNORDERED: section = &unorderedSections[body.name]; break;
+                case ORDERED: section = &orderedSections[body.name]; break;
+                case LIST: section = &listSections[body.name]; break;
+            }
+            LazySection& lazy = lazySections[section];
+            if (body.type != UNORDERED && replaced.insert(section).second && !lazy.parts.empty()) {
+                lazy.parts.clear();
+                ++overrides;
+            }
+            lazy.parts.push_back({parsed.text, body.begin, body.end, body.first_line});
+        }
+        return overrides;
+    }
+
+    // Tokenizer sink passing the lines of one file on to an EventHandler, includes are streamed
+    // in place. 'stack' holds the canonicalKey() of every frame of 'trace'.
+    class EventSink {
+       public:
+        EventSink(EventHandler& handler, errhandle::StackTrace& trace, std::vector<std::string>& stack, const Options& options)
+            : handler(handler), trace(trace), stack(stack), options(options) {}
+
+        void include(std::string_view path, int) {
+            close();
+            streamFile(fs::path(path), trace, stack, handler, options);
+        }
+
+        void section(SectionType sectionType, std::string_view name) {
+            close();
+            type = sectionType;
+            sectionName = name;
+            open();
+        }
+
+        void entry(std::string_view key, std::string_view value) {
+            if (!opened) open();
+            handler.entry(key, value);
+        }
+
+        void item(std::string_view value) {
+            if (!opened) open();
+            handler.listItem(value);
+        }
+
+        void close() {
+            if (opened) handler.sectionEnd(type, sectionName);
+            opened = false;
+        }
+
+       private:
+        EventHandler& handler;
+        errhandle::StackTrace& trace;
+        std::vector<std::string>& stack;
+        const Options& options;
+        SectionType type = UNORDERED;
+        std::string sectionName;
+        bool opened = false;
+
+        void open() {
+            handler.sectionBegin(type, sectionName);
+            opened = true;
+        }
+    };
+
+    // loops are found by canonical path like in resolve()
+    static void streamFile(
+        const fs::path& filename, errhandle::StackTrace& trace, std::vector<std::string>& stack, EventHandler& handler,
+        const Options& options
+    ) {
+        fs::path absolute_path = make_absolute_path(filename, trace.empty() ? fs::path() : trace.back().file);
+        std::string key = canonicalKey(absolute_path);
+
+        auto loop_search_res = std::find(stack.begin(), stack.end(), key);
+        if (loop_search_res != stack.end()) throw std::runtime_error("file loop found");
+
+        io::FileBuffer file(absolute_path);
+        trace.push_back(
+            errhandle::StackFrame{
+                .file = absolute_path
+            }
+        );
+        stack.push_back(std::move(key));
+        handler.fileBegin(trace);
+        EventSink sink(handler, trace, stack, options);
+        tokenize(file.view(), options.delimiter, trace.back().line_number, sink);
+        sink.close();
+        handler.fileEnd(trace);
+        stack.pop_back();
+        trace.pop_back();
+    }
+
+    // with Options::incremental, every loaded file by absolute path, for refresh()
+    std::unordered_map<std::string, std::shared_ptr<ParsedFile>> parsedFiles;
+
+    template <class Sink>
+    static void handleCommand(std::string_view line, int line_number, Sink& sink) {
+        if (line.empty()) throw std::runtime_error("Command expected after '!'");
+        // command name is everything before the first space, the argument is the rest of the line
+        size_t space = line.find(' ');
+        std::string_view cmd = line.substr(0, space);
+        std::string_view arg = space == std::string_view::npos ? std::string_view() : line.substr(space + 1);
+
+        if (cmd == "include") {
+            sink.include(arg, line_number);
+            return;
+        }
+        throw std::runtime_error("Unknown command '" + std::string(cmd) + "'");
+    }
+
+    // Paths of the !include lines of 'text', found without tokenizing it. Lines the tokenizer
+    // rejects are skipped here, it reports them.
+    static std::vector<fs::path> findIncludes(std::string_view text) {
+        struct Sink {
+            std::vector<fs::path> paths;
+            void include(std::string_view path, int) { paths.emplace_back(path); }
+        } sink;
+        for (size_t pos = scan::find(text, "!"); pos != std::string_view::npos; pos = scan::find(text, "!", pos + 1)) {
+            // only at the start of a line, after the '\r' and ' ' scanLine() skips
+            size_t begin = pos;
+            while (begin > 0 && (text[begin - 1] == ' ' || text[begin - 1] == '\r')) --begin;
+            if (begin > 0 && text[begin - 1] != '\n') continue;
+            size_t end = std::min(text.find('\n', pos), text.size());
+            while (end > pos && text[end - 1] == '\r') --end;
+            try {
+                handleCommand(strutils::trimLeftView(text.substr(pos, end - pos), '!'), 0, sink);
+            } catch (std::exception&) {
+            }
+        }
+        return std::move(sink.paths);
+    }
+
+    // 'resource' is the memory resource of the config's sections, nullptr for the default one
+    static std::shared_ptr<ParsedFile> makeParsedFile(const std::shared_ptr<std::pmr::memory_resource>& resource) {
+        return std::make_shared<ParsedFile>(resource);
+    }
+
+    // never throws, problems are recorded in ParsedFile::error
+    static std::shared_ptr<ParsedFile> parseFile(
+        const fs::path& absolute_path, const Options& options, const std::shared_ptr<std::pmr::memory_resource>& resource
+    ) {
+        if (!options.stats) return options.lazy ? scanFile(absolute_path, options.delimiter) : tokenizeFile(absolute_path, options, resource);
+        auto start = std::chrono::steady_clock::now();
+        auto parsed = options.lazy ? scanFile(absolute_path, options.delimiter) : tokenizeFile(absolute_path, options, resource);
+        parsed->parseTime = std::chrono::steady_clock::now() - start;
+        return parsed;
+    }
+
+    static std::shared_ptr<ParsedFile> tokenizeFile(
+        const fs::path& absolute_path, const Options& options, const std::shared_ptr<std::pmr::memory_resource>& resource
+    ) {
+        auto parsed = makeParsedFile(resource);
+        try {
+            io::FileBuffer file(absolute_path);
+            parsed->fingerprint = file.fingerprint();
+            parsed->bytes = file.view().size();
+            parsed->lines = parseText(file.view(), options.delimiter, *parsed);
+        } catch (std::exception& ex) {
+            parsed->error = ex.what();
+        }
+        return parsed;
+    }
+
+    // Options::lazy: same checks as parseFile(), but only the places of the sections are kept
+    static std::shared_ptr<ParsedFile> scanFile(
+        const fs::path& absolute_path, const std::string& delimiter, std::shared_ptr<const io::FileBuffer> file = nullptr
+    ) {
+        auto parsed = makeParsedFile(nullptr);
+        int line_number = 0;
+        try {
+            // the text is kept until the sections are used, a copy is not changed by later edits
+            parsed->text = file ? std::move(file) : std::make_shared<const io::FileBuffer>(absolute_path, false);
+            parsed->fingerprint = parsed->text->fingerprint();
+            std::string_view text = parsed->text->view();
+            parsed->bytes = text.size();
+            ScanSink sink(*parsed, text, line_number);
+            tokenize(text, delimiter, line_number, sink);
+            sink.close(text.size());
+            parsed->lines = line_number;
+        } catch (std::exception& ex) {
+            parsed->error = ex.what();
+            parsed->error_line = line_number;
+        }
+        return parsed;
+    }
+
+    // returns the number of lines in 'text', or up to the failed one
+    static int parseText(std::string_view text, const std::string& delimiter, ParsedFile& parsed) {
+        int line_number = 0;
+        try {
+            FileSink sink(parsed);
+            tokenize(text, delimiter, line_number, sink);
+        } catch (std::exception& ex) {
+            parsed.error = ex.what();
+            parsed.error_line = line_number;
+        }
+        return line_number;
+    }
+
+    // Offsets where the pieces of 'text' begin. Every piece but the first starts with a section
+    // header, so it can be tokenized without knowing what comes before it.
+    static std::vector<size_t> shardText(std::string_view text, const std::string& delimiter, size_t shards) {
+        std::vector<size_t> offsets{0};
+        for (size_t i = 1; i < shards; ++i) {
+            size_t pos = scan::find(text, "\n", std::max(text.size() / shards * i, offsets.back()));
+            while (pos != std::string_view::npos && ++pos < text.size()) {
+                scan::LineScan scanned = scan::scanLine(text, pos, delimiter);
+                char first = scanned.begin < scanned.end ? text[scanned.begin] : '\0';
+                if (first == '[' || first == '<' || first == '{') {
+                    offsets.push_back(pos);
+                    break;
+                }
+                pos = scanned.next - 1;
+            }
+            if (offsets.size() == i) break;  // no header till the end of the file
+        }
+        return offsets;
+    }
+
+    // Appends a piece tokenized by shardText() to the file it was cut from, as if both were
+    // tokenized in one go. 'first_line' is the number of lines before the piece.
+    static void appendShard(ParsedFile& parsed, ParsedFile& shard, int first_line) {
+        if (!parsed.error.empty()) return;
+        for (const ParsedFile::Include& include : shard.includes)
+            parsed.includes.push_back({include.path, include.line_number + first_line});
+        if (!shard.error.empty()) {
+            parsed.error = std::move(shard.error);
+            parsed.error_line = shard.error_line + first_line;
+            return;
+        }
+
+        for (auto& [sec_name, sec] : shard.unorderedSections) {
+            auto& target = parsed.unorderedSections[sec_name];
+            for (auto& [key, value] : sec) target[key] = std::move(value);
+        }
+        for (auto& [sec_name, sec] : shard.orderedSections) {
+            auto& target = parsed.orderedSections[sec_name];
+            target.insert(target.end(), std::make_move_iterator(sec.begin()), std::make_move_iterator(sec.end()));
+        }
+        for (auto& [sec_name, sec] : shard.listSections) {
+            auto& target = parsed.listSections[sec_name];
+            target.insert(target.end(), std::make_move_iterator(sec.begin()), std::make_move_iterator(sec.end()));
+        }
+    }
+
+    // Splits 'text' into lines and reports them to 'sink':
+    //   include(path, line_number)   for '!include path'
+    //   section(type, name)          for a section header
+    //   entry(key, value)            for a line of an unordered or ordered section
+    //   item(value)                  for a line of a list section
+    // 'line_number' is the number of the current line, valid when an exception is thrown.
+    template <class Sink>
+    static void tokenize(std::string_view text, const std::string& delimiter, int& line_number, Sink& sink) {
+        SectionType type = UNORDERED;
+
+        for (size_t pos = 0; pos < text.size();) {
+            scan::LineScan scanned = scan::scanLine(text, pos, delimiter);
+            pos = scanned.next;
+
+            ++line_number;
+            std::string_view line = text.substr(scanned.begin, scanned.end - scanned.begin);
+            if (line.empty()) continue;
+
+            // commands (only include at this moment, maybe smth more later)
+            if (strutils::startsWith(line, '!')) {
+                handleCommand(strutils::trimLeftView(line, '!'), line_number, sink);
+                continue;
+            }
+            // comments
+            if (strutils::startsWith(line, '#')) continue;
+
+            // unordered section
+            if (strutils::startsWith(line, '[')) {
+                line = strutils::trimRightView(line);
+                if (!strutils::endsWith(line, ']')) throw std::runtime_error("Incorrect section format");
+                type = UNORDERED;
+                sink.section(type, line.substr(1, line.length() - 2));
+                continue;
+            }
+
+            // ordered section
+            if (strutils::startsWith(line, '<')) {
+                line = strutils::trimRightView(line);
+                if (!strutils::endsWith(line, '>')) throw std::runtime_error("Incorrect section format");
+                type = ORDERED;
+                sink.section(type, line.substr(1, line.length() - 2));
+                continue;
+            }
+
+            // list section
+            if (strutils::startsWith(line, '{')) {
+                line = strutils::trimRightView(line);
+                if (!strutils::endsWith(line, '}')) throw std::runtime_error("Incorrect section format");
+                type = LIST;
+                sink.section(type, strutils::trimView(line.substr(1, line.length() - 2)));
+                continue;
+            }
+
+            if (type == LIST) {
+                sink.item(strutils::trimView(line));
+                continue;
+            }
+
+            // key-value parsing, the value is everything after the first delimiter
+            if (scanned.delimiter == std::string_view::npos) throw std::runtime_error("Incorrect line format");
+            size_t delimPos = scanned.delimiter - scanned.begin;
+            sink.entry(strutils::trimView(line.substr(0, delimPos)), strutils::trimView(line.substr(delimPos + delimiter.length())));
+        }
+    }
+
+    static void error(const errhandle::StackTrace& trace, const std::string& description) {
+        std::string message = "Config parser: " + description;
+        if(!trace.empty()){
+            message += "\nStack trace: ";
+            for (auto it = trace.rbegin(); it != trace.rend(); ++it) {
+                message += "\n";
+                message += it->file;
+                message += ":";
+                message += std::to_string(it->line_number);
+            }
+        }
+        throw std::runtime_error(message);
+    }
+
+    // Tokenizes files on a thread pool. Includes are queued as soon as the including file is
+    // tokenized, so a whole include tree is read in parallel; load() still merges in file order.
+    // Files bigger than two Options::shardSize are cut at section headers and the pieces are
+    // tokenized as separate tasks.
+    class ParallelParser {
+       public:
+        // 'known' returns files that need not be read, or nullptr
+        // 'resource' as for makeParsedFile()
+        ParallelParser(
+            const Options& options, unsigned threads, std::shared_ptr<std::pmr::memory_resource> resource,
+            std::function<std::shared_ptr<ParsedFile>(const fs::path&)> known
+        )
+            : options(options),
+              threads(threads),
+              resource(std::move(resource)),
+              known(std::move(known)),
+              pool(threads),
+              io(options.ioThreads) {}
+
+        ~ParallelParser() {
+            // the pools post to each other, both stop taking tasks before the members go away
+            io.stop();
+            pool.stop();
+        }
+
+        // Hands the parsed file over if nothing else holds it, so that it can be merged by moving.
+        // A file asked for again after that is parsed again.
+        std::shared_ptr<ParsedFile> get(const fs::path& absolute_path) {
+            std::string key = canonicalKey(absolute_path);
+            std::shared_future<void> ready;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready = submit(absolute_path, key);
+            }
+            ready.get();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                std::shared_ptr<ParsedFile>& parsed = files[key].parsed;
+                if (parsed && parsed.use_count() > 1) return parsed;
+                if (parsed) return std::move(parsed);
+            }
+            return parseFile(absolute_path, options, resource);
+        }
+
+        void prefetch(const fs::path& absolute_path) {
+            std::string key = canonicalKey(absolute_path);
+            std::lock_guard<std::mutex> lock(mutex);
+            submit(absolute_path, key);
+        }
+
+       private:
+        using Promise = std::shared_ptr<std::promise<void>>;
+        using Clock = std::chrono::steady_clock;
+
+        struct File {
+            std::shared_future<void> ready;
+            std::shared_ptr<ParsedFile> parsed;  // set before 'ready', empty once handed over
+        };
+
+        // pieces of one sharded file, the last finished piece puts them together
+        struct ShardedFile {
+            fs::path path;
+            Promise promise;
+            std::shared_ptr<const io::FileBuffer> file;
+            std::vector<size_t> offsets;
+            std::vector<std::shared_ptr<ParsedFile>> shards;
+            std::vector<int> lines;
+            std::atomic<size_t> remaining;
+            Clock::time_point started;  // with Options::stats
+
+            // opens the file unless it was read before
+            ShardedFile(const fs::path& path, Promise promise, std::shared_ptr<const io::FileBuffer> file)
+                : path(path),
+                  promise(std::move(promise)),
+                  file(file ? std::move(file) : std::make_shared<const io::FileBuffer>(path)) {}
+        };
+
+        const Options& options;
+        unsigned threads;
+        std::shared_ptr<std::pmr::memory_resource> resource;
+        std::function<std::shared_ptr<ParsedFile>(const fs::path&)> known;
+        std::mutex mutex;
+        std::unordered_map<std::string, File> files;  // by canonicalKey()
+        // last members, workers are joined before the state above goes away
+        detail::ThreadPool pool;
+        detail::ThreadPool io;  // Options::ioThreads
+
+        // paths and keys of the files 'parsed' includes, found without holding 'mutex'
+        static std::vector<std::pair<fs::path, std::string>> includes(const std::vector<fs::path>& paths, const fs::path& from) {
+            std::vector<std::pair<fs::path, std::string>> res;
+            for (const fs::path& path : paths) {
+                fs::path absolute_path = make_absolute_path(path, from);
+                std::string key = canonicalKey(absolute_path);
+                res.emplace_back(std::move(absolute_path), std::move(key));
+            }
+            return res;
+        }
+
+        static std::vector<fs::path> includePaths(const ParsedFile& parsed) {
+            std::vector<fs::path> res;
+            for (const ParsedFile::Include& include : parsed.includes) res.push_back(include.path);
+            return res;
+        }
+
+        // caller holds 'mutex', 'key' is canonicalKey(absolute_path)
+        std::shared_future<void> submit(const fs::path& absolute_path, const std::string& key) {
+            auto it = files.find(key);
+            if (it != files.end()) return it->second.ready;
+            if (std::shared_ptr<ParsedFile> parsed = known(absolute_path)) {
+                std::promise<void> ready;
+                ready.set_value();
+                std::shared_future<void> res = files.emplace(key, File{ready.get_future().share(), parsed}).first->second.ready;
+                for (const auto& [include, includeKey] : includes(includePaths(*parsed), absolute_path)) submit(include, includeKey);
+                return res;
+            }
+
+            auto promise = std::make_shared<std::promise<void>>();
+            std::shared_future<void> res = promise->get_future().share();
+            files.emplace(key, File{res, nullptr});
+            if (options.ioThreads) {
+                io.post([this, absolute_path, promise] { read(absolute_path, promise); });
+                return res;
+            }
+            post(absolute_path, promise, nullptr, Clock::time_point());
+            return res;
+        }
+
+        void post(const fs::path& absolute_path, const Promise& promise, std::shared_ptr<const io::FileBuffer> file, Clock::time_point started) {
+            pool.post([this, absolute_path, promise, file = std::move(file), started] {
+                try {
+                    parse(absolute_path, promise, file, started);
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+        }
+
+        // Options::ioThreads: reads the file, submits what it includes and leaves the tokenizing to 'pool'
+        void read(const fs::path& absolute_path, const Promise& promise) {
+            Clock::time_point started = options.stats ? Clock::now() : Clock::time_point();
+            std::shared_ptr<const io::FileBuffer> file;
+            try {
+                file = std::make_shared<const io::FileBuffer>(absolute_path, !options.lazy);
+                file->willNeed();
+                auto found = includes(findIncludes(file->view()), absolute_path);
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const auto& [include, key] : found) submit(include, key);
+            } catch (std::exception&) {
+                // parse() opens the file again and reports what went wrong
+                file.reset();
+            }
+            post(absolute_path, promise, std::move(file), started);
+        }
+
+        // 'file' and 'started' are set if the file was read by read()
+        void parse(
+            const fs::path& absolute_path, const Promise& promise, std::shared_ptr<const io::FileBuffer> file, Clock::time_point started
+        ) {
+            if (options.stats && !file) started = Clock::now();
+            if (options.lazy) {
+                auto parsed = scanFile(absolute_path, options.delimiter, std::move(file));
+                if (options.stats) parsed->parseTime = Clock::now() - started;
+                finish(absolute_path, promise, std::move(parsed));
+                return;
+            }
+            std::shared_ptr<ShardedFile> sharded;
+            try {
+                sharded = std::make_shared<ShardedFile>(absolute_path, promise, std::move(file));
+                sharded->started = started;
+            } catch (std::exception& ex) {
+                auto parsed = makeParsedFile(resource);
+                parsed->error = ex.what();
+                finish(absolute_path, promise, std::move(parsed));
+                return;
+            }
+
+            std::string_view text = sharded->file->view();
+            size_t shards = options.shardSize ? std::min<size_t>(threads, text.size() / options.shardSize) : 1;
+            sharded->offsets = shards > 1 ? shardText(text, options.delimiter, shards) : std::vector<size_t>{0};
+            if (sharded->offsets.size() == 1) {
+                auto parsed = makeParsedFile(resource);
+                parsed->fingerprint = sharded->file->fingerprint();
+                parsed->bytes = text.size();
+                parsed->lines = parseText(text, options.delimiter, *parsed);
+                if (options.stats) parsed->parseTime = Clock::now() - sharded->started;
+                finish(absolute_path, promise, std::move(parsed));
+                return;
+            }
+
+            size_t count = sharded->offsets.size();
+            sharded->offsets.push_back(text.size());
+            sharded->shards.resize(count);
+            sharded->lines.resize(count);
+            sharded->remaining = count;
+            for (size_t i = 1; i < count; ++i) pool.post([this, sharded, i] { parseShard(sharded, i); });
+            parseShard(sharded, 0);
+        }
 
-class _Config {
-   private:
-    static fs::path make_absolute_path(const fs::path& included, const fs::path& from) {
-        if (included.is_absolute()) return included;
-        else if (from.empty()) return fs::absolute(included);
-        else return fs::absolute(from.parent_path() / included);
+        void parseShard(const std::shared_ptr<ShardedFile>& sharded, size_t i) {
+            try {
+                std::string_view text = sharded->file->view();
+                auto shard = makeParsedFile(resource);
+                sharded->lines[i] = parseText(
+                    text.substr(sharded->offsets[i], sharded->offsets[i + 1] - sharded->offsets[i]), options.delimiter, *shard
+                );
+                sharded->shards[i] = std::move(shard);
+            } catch (...) {
+                // only allocation failures get here, report them once all pieces are done
+            }
+            if (--sharded->remaining != 0) return;
+
+            try {
+                for (const auto& shard : sharded->shards)
+                    if (!shard) throw std::bad_alloc();
+                std::shared_ptr<ParsedFile> parsed = sharded->shards[0];
+                parsed->fingerprint = sharded->file->fingerprint();
+                int first_line = sharded->lines[0];
+                for (size_t j = 1; j < sharded->shards.size(); ++j) {
+                    appendShard(*parsed, *sharded->shards[j], first_line);
+                    first_line += sharded->lines[j];
+                }
+                parsed->bytes = sharded->file->view().size();
+                parsed->lines = first_line;
+                if (options.stats) parsed->parseTime = Clock::now() - sharded->started;
+                finish(sharded->path, sharded->promise, std::move(parsed));
+            } catch (...) {
+                sharded->promise->set_exception(std::current_exception());
+            }
+        }
+
+        void finish(const fs::path& absolute_path, const Promise& promise, std::shared_ptr<ParsedFile> parsed) {
+            auto found = includes(includePaths(*parsed), absolute_path);
+            std::string key = canonicalKey(absolute_path);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const auto& [include, includeKey] : found) submit(include, includeKey);
+                files[key].parsed = std::move(parsed);
+            }
+            promise->set_value();
+        }
+    };
+
+    unsigned loadThreads() const {
+        if (options.threads != 0) return options.threads;
+        unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+        // a file big enough to be sharded gets all cores
+        for (const fs::path& filename : configFileNames) {
+            std::error_code ec;
+            uintmax_t size = fs::file_size(make_absolute_path(filename, fs::path()), ec);
+            if (!ec && options.shardSize && size / options.shardSize >= 2) return hardware;
+        }
+        return std::min<size_t>(hardware, configFileNames.size());
     }
 
-    enum SectionType { UNORDERED,
-                       ORDERED,
-                       LIST };
-    std::vector<fs::path> configFileNames;
-    std::unordered_map<std::string, unordered_container> unorderedSections;
-    std::unordered_map<std::string, ordered_container> orderedSections;
-    std::unordered_map<std::string, list_container> listSections;
+    // Parsed files shared by the configs loaded with Options::processCache, by the options they
+    // were parsed with and canonical path. An entry is used only while the file keeps the
+    // fingerprint it was read with.
+    class ProcessCache {
+       public:
+        std::shared_ptr<ParsedFile> find(const Options& options, const std::string& canonical) {
+            std::shared_ptr<ParsedFile> parsed;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = files.find(key(options, canonical));
+                if (it == files.end()) return nullptr;
+                parsed = it->second;
+            }
+            return parsed->fingerprint == io::Fingerprint::of(fs::path(canonical)) ? parsed : nullptr;
+        }
 
-    std::string delimiter = defaultDelimiter;
+        void store(const Options& options, const std::string& canonical, std::shared_ptr<ParsedFile> parsed) {
+            std::lock_guard<std::mutex> lock(mutex);
+            files[key(options, canonical)] = std::move(parsed);
+        }
 
-    void handleCommand(const std::string& line, errhandle::StackTrace& trace) {
-        errhandle::StackFrame& frame = trace.back();
-        std::vector<std::string> tokens = strutils::split(line, " ");
-        if (tokens.size() == 0) throw std::runtime_error("Command expected after '!'");
-        std::string cmd = tokens[0];
-        tokens.erase(tokens.begin());
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            files.clear();
+        }
 
-        if (cmd == "include") {
-            parse(strutils::concat(tokens), trace);
-            return;
+       private:
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<ParsedFile>> files;
+
+        static std::string key(const Options& options, const std::string& canonical) {
+            return options.delimiter + (options.lazy ? '\1' : '\0') + canonical;
         }
-        throw std::runtime_error("Unknown command '" + cmd + "'");
+    };
+
+    static ProcessCache& processCache() {
+        static ProcessCache cache;
+        return cache;
     }
 
-    void error(const errhandle::StackTrace& trace, const std::string& description) {
-        std::string message = "Config parser: " + description;
-        if(!trace.empty()){
-            message += "\nStack trace: ";
-            for (auto it = trace.rbegin(); it != trace.rend(); ++it) {
-                message += "\n";
-                message += it->file;
-                message += ":";
-                message += std::to_string(it->line_number);
+    // the same file reached through different spellings or links gets the same key
+    static std::string canonicalKey(const fs::path& absolute_path) {
+        std::error_code ec;
+        fs::path canonical = fs::weakly_canonical(absolute_path, ec);
+        return ec ? absolute_path.lexically_normal().native() : canonical.native();
+    }
+
+    // Files of one load in merge order. Every distinct file is parsed once and merged at each
+    // place it is included from.
+    struct LoadPlan {
+        std::unordered_map<std::string, std::shared_ptr<ParsedFile>> files;  // by canonical path
+        std::unordered_map<std::string, size_t> uses;
+        std::vector<std::string> order;
+        std::vector<std::string> stack;  // canonical paths of the frames of the current trace
+        std::unordered_map<std::string, std::string> canonical;  // by absolute path
+        // with Options::stats, absolute paths of files that were not read by this load
+        std::mutex reusedMutex;
+        std::unordered_set<std::string> reused;
+
+        const std::string& key(const fs::path& absolute_path) {
+            auto it = canonical.find(absolute_path.native());
+            if (it == canonical.end()) it = canonical.emplace(absolute_path.native(), canonicalKey(absolute_path)).first;
+            return it->second;
+        }
+    };
+
+    // 'previous' is the config being refreshed, its files that did not change are not read again
+    void parseAll(const _Config* previous = nullptr) {
+        auto start = std::chrono::steady_clock::now();
+        if (options.stats) stats = std::make_unique<LoadStats>();
+        LoadPlan plan;
+
+        std::unordered_map<std::string, std::shared_ptr<ParsedFile>> unchanged;
+        if (previous) {
+            for (const auto& [path, parsed] : previous->parsedFiles)
+                if (parsed->fingerprint == io::Fingerprint::of(fs::path(path))) unchanged.emplace(path, parsed);
+        }
+        // files that need not be read again
+        auto known = [&](const fs::path& absolute_path) -> std::shared_ptr<ParsedFile> {
+            std::shared_ptr<ParsedFile> res;
+            auto it = unchanged.find(absolute_path.native());
+            if (it != unchanged.end()) res = it->second;
+            else if (options.processCache) res = processCache().find(options, canonicalKey(absolute_path));
+            if (res && stats) {
+                std::lock_guard<std::mutex> lock(plan.reusedMutex);
+                plan.reused.insert(absolute_path.native());
             }
+            return res;
+        };
+
+        unsigned threads = loadThreads();
+        std::unique_ptr<ParallelParser> parallel;
+        if (threads > 1 || options.ioThreads) {
+            parallel = std::make_unique<ParallelParser>(options, threads, counting, known);
+            for (const fs::path& filename : configFileNames) parallel->prefetch(make_absolute_path(filename, fs::path()));
         }
-        throw std::runtime_error(message);
-    }
+        auto source = [&](const fs::path& absolute_path) {
+            std::shared_ptr<ParsedFile> parsed = parallel ? parallel->get(absolute_path) : known(absolute_path);
+            if (!parsed) parsed = parseFile(absolute_path, options, counting);
+            // whichever way it was parsed, storing a file found in the cache again changes nothing
+            if (options.processCache && parsed->error.empty()) processCache().store(options, plan.key(absolute_path), parsed);
+            if (options.incremental) parsedFiles.emplace(absolute_path.native(), parsed);
+            return parsed;
+        };
 
-    void parseAll() {
         for (const fs::path& filename : configFileNames) {
             errhandle::StackTrace trace;
             try{
-                parse(filename, trace);
+                resolve(filename, trace, source, plan);
             } catch(std::exception& ex){
                 error(trace, ex.what());
             }
         }
+        auto parsed_at = std::chrono::steady_clock::now();
+
+        size_t overrides = 0;
+        for (const std::string& key : plan.order) {
+            std::shared_ptr<ParsedFile>& parsed = plan.files[key];
+            size_t& uses = plan.uses[key];
+            --uses;
+            // after its last use a file nobody else holds can give its sections away
+            if (options.lazy) overrides += mergeLazy(*parsed);
+            else if (uses == 0 && parsed.use_count() == 1) overrides += merge(std::move(*parsed));
+            else overrides += merge(*parsed);
+            if (uses == 0) parsed.reset();
+        }
+
+        if (!stats) return;
+        stats->overrides = overrides;
+        stats->parseTime = parsed_at - start;
+        stats->mergeTime = std::chrono::steady_clock::now() - parsed_at;
+        stats->allocations = counting->allocations;
+        stats->allocatedBytes = counting->bytes;
+        stats->memoryBytes = memoryFootprint();
+        for (const auto& [name, section] : unorderedSections) stats->sections.push_back({UNORDERED, name, section.size()});
+        for (const auto& [name, section] : orderedSections) stats->sections.push_back({ORDERED, name, section.size()});
+        for (const auto& [name, section] : listSections) stats->sections.push_back({LIST, name, section.size()});
+        if (options.onStats) options.onStats(*stats);
     }
 
-    void parse(const fs::path& filename, errhandle::StackTrace& trace) {
-        fs::path absolute_path = make_absolute_path(filename, trace.empty() ? fs::path() : trace.back().file);
+    // Estimate of the memory held by the sections: map buckets and nodes, vector buffers and
+    // strings that do not fit into the small buffer.
+    size_t memoryFootprint() const {
+        auto text = [](const std::string& s) { return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0; };
+        // node of a hash map: next pointer, value and cached hash
+        auto node = [](const auto& map) { return sizeof(void*) + sizeof(typename std::decay_t<decltype(map)>::value_type) + sizeof(size_t); };
+        auto table = [&](const auto& map) { return map.bucket_count() * sizeof(void*) + map.size() * node(map); };
+
+        size_t res = table(unorderedSections) + table(orderedSections) + table(listSections);
+        for (const auto& [name, section] : unorderedSections) {
+            res += text(name) + table(section);
+            for (const auto& [key, value] : section) res += text(key) + text(value.value);
+        }
+        for (const auto& [name, section] : orderedSections) {
+            res += text(name) + section.capacity() * sizeof(section[0]);
+            for (const auto& [key, value] : section) res += text(key) + text(value.value);
+        }
+        for (const auto& [name, section] : listSections) {
+            res += text(name) + section.capacity() * sizeof(Value);
+            for (const Value& value : section) res += text(value.value);
+        }
+        return res;
+    }
 
-        auto loop_search_res = std::find_if(trace.begin(), trace.end(), [&](const errhandle::StackFrame& sf){ return sf.file == absolute_path; });
-        if (loop_search_res != trace.end()) throw std::runtime_error("file loop found");
-
-        
-        unordered_container mainSection;
-        std::unordered_map<std::string, unordered_container> unordSectionsTmp;
-        std::unordered_map<std::string, ordered_container> ordSectionsTmp;
-        std::unordered_map<std::string, list_container> listSectionsTmp;
-        
-        std::ifstream file(absolute_path);
-        if (file.fail()) {
-            throw std::runtime_error(
-                "can not open file '" + absolute_path.string() + "': " + std::string(strerror(errno))
+    // Follows the includes of a parsed file depth-first and lists every file after its includes,
+    // 'trace' holds the include chain for error messages.
+    template <class Source>
+    void resolve(const fs::path& filename, errhandle::StackTrace& trace, Source& source, LoadPlan& plan) {
+        fs::path absolute_path = make_absolute_path(filename, trace.empty() ? fs::path() : trace.back().file);
+        std::string key = plan.key(absolute_path);
+
+        auto loop_search_res = std::find(plan.stack.begin(), plan.stack.end(), key);
+        if (loop_search_res != plan.stack.end()) throw std::runtime_error("file loop found");
+
+        std::shared_ptr<ParsedFile>& parsed = plan.files[key];
+        bool reused = parsed != nullptr;
+        if (!parsed) parsed = source(absolute_path);
+        if (!parsed->error.empty() && parsed->error_line == 0) throw std::runtime_error(parsed->error);
+        parsedFileNames.push_back(absolute_path);
+        if (stats) {
+            if (!reused) {
+                std::lock_guard<std::mutex> lock(plan.reusedMutex);
+                reused = plan.reused.count(absolute_path.native()) > 0;
+            }
+            stats->files.push_back(
+                LoadStats::File{
+                    .path = absolute_path,
+                    .bytes = parsed->bytes,
+                    .lines = parsed->lines,
+                    .parseTime = reused ? std::chrono::nanoseconds(0) : parsed->parseTime,
+                    .depth = static_cast<int>(trace.size()),
+                    .includes = static_cast<int>(parsed->includes.size()),
+                    .reused = reused
+                }
             );
         }
 
@@ -266,249 +2995,456 @@ class _Config {
                 .file = absolute_path
             }
         );
+        plan.stack.push_back(key);
         errhandle::StackFrame& frame = trace.back();
-        
-        // name of current section
-        std::string sectionName;
-        SectionType type = UNORDERED;
-
-        std::string line;
-        std::string key, value;
-
-        while (getline(file, line)) {
-            ++frame.line_number;
-            line = strutils::trim(line, '\r');
-            line = strutils::trimLeft(line);
-            if (line.empty()) continue;
-
-            // commands (only include at this moment, maybe smth more later)
-            if (strutils::startsWith(line, "!")) {
-                handleCommand(strutils::trimLeft(line, '!'), trace);
-                continue;
-            }
 
-            // comments
-            if (strutils::startsWith(line, "#")) continue;
-
-            // unordered section
-            if (strutils::startsWith(line, "[")) {
-                line = strutils::trimRight(line);
-                if (!strutils::endsWith(line, "]")) throw std::runtime_error("Incorrect section format");
-                type = UNORDERED;
-                sectionName = line.substr(1, line.length() - 2);
-                unordSectionsTmp[sectionName];
-                continue;
-            }
-
-            // ordered section
-            if (strutils::startsWith(line, "<")) {
-                line = strutils::trimRight(line);
-                if (!strutils::endsWith(line, ">")) throw std::runtime_error("Incorrect section format");
-                sectionName = line.substr(1, line.length() - 2);
-                type = ORDERED;
-                ordSectionsTmp[sectionName];
-                continue;
-            }
-
-            // list section
-            if (strutils::startsWith(line, "{")) {
-                line = strutils::trimRight(line);
-                if (!strutils::endsWith(line, "}")) throw std::runtime_error("Incorrect section format");
-                sectionName = strutils::trim(line.substr(1, line.length() - 2));
-                type = LIST;
-                listSectionsTmp[sectionName];
-                continue;
-            }
+        for (const ParsedFile::Include& include : parsed->includes) {
+            frame.line_number = include.line_number;
+            resolve(include.path, trace, source, plan);
+        }
+        if (!parsed->error.empty()) {
+            frame.line_number = parsed->error_line;
+            throw std::runtime_error(parsed->error);
+        }
 
-            // key-value parsing
-            if (type != LIST) {
-                std::vector<std::string> splitt = strutils::split(line, delimiter);
-                if (splitt.size() < 2) throw std::runtime_error("Incorrect line format");
-                key = strutils::trim(splitt[0]);
-                splitt.erase(splitt.begin());
-                value = strutils::trim(strutils::concat(splitt, delimiter));
-            }
+        plan.order.push_back(key);
+        ++plan.uses[key];
+        plan.stack.pop_back();
+        trace.pop_back();
+    }
 
-            switch (type) {
-                case UNORDERED: {
-                    unordSectionsTmp[sectionName][key] = value;
-                    break;
-                }
-                case ORDERED: {
-                    ordSectionsTmp[sectionName].push_back({key, value});
-                    break;
-                }
-                case LIST: {
-                    listSectionsTmp[sectionName].push_back(strutils::trim(line));
-                    break;
-                }
+    // Each file overrides what it includes: unordered sections key by key, ordered and list
+    // sections as a whole. Empty unordered sections are not created. Returns the number of keys
+    // and sections that replaced existing ones.
+    size_t merge(const ParsedFile& parsed) {
+        size_t overrides = 0;
+        for (const auto& [sec_name, sec] : parsed.unorderedSections){
+            if (sec.empty()) continue;
+            unordered_container& target = unorderedSections[sec_name];
+            for (const auto& [key, value]: sec){
+                overrides += !target.insert_or_assign(key, value).second;
             }
         }
-        file.close();
+        for (const auto& [sec_name, sec] : parsed.orderedSections) {
+            overrides += !orderedSections.insert_or_assign(sec_name, sec).second;
+        }
+        for (const auto& [sec_name, sec] : parsed.listSections){ 
+            overrides += !listSections.insert_or_assign(sec_name, sec).second;
+        }
+        return overrides;
+    }
 
-        // merge
-        for (const auto& [sec_name, sec] : unordSectionsTmp){
-            for (const auto& [key, value]: sec){
-                unorderedSections[sec_name][key] = value;
+    // Same as above, taking the sections out of 'parsed'. With the same memory resource on both
+    // sides (see makeParsedFile()) section buffers and map nodes change owner without being copied.
+    size_t merge(ParsedFile&& parsed) {
+        size_t overrides = 0;
+        for (auto& [sec_name, sec] : parsed.unorderedSections) {
+            if (sec.empty()) continue;
+            auto [it, inserted] = unorderedSections.try_emplace(sec_name, std::move(sec));
+            if (inserted) continue;
+            unordered_container& target = it->second;
+            if (target.get_allocator() == sec.get_allocator()) {
+                // moves the nodes of keys that are new, the rest stays behind
+                target.merge(sec);
             }
+            for (auto& [key, value] : sec) overrides += !target.insert_or_assign(key, std::move(value)).second;
         }
-        for (const auto& [sec_name, sec] : ordSectionsTmp) {
-            orderedSections[sec_name] = sec;
+        for (auto& [sec_name, sec] : parsed.orderedSections) {
+            overrides += !orderedSections.insert_or_assign(sec_name, std::move(sec)).second;
         }
-        for (const auto& [sec_name, sec] : listSectionsTmp){ 
-            listSections[sec_name] = sec;
+        for (auto& [sec_name, sec] : parsed.listSections) {
+            overrides += !listSections.insert_or_assign(sec_name, std::move(sec)).second;
         }
-
-        trace.pop_back();
+        return overrides;
     }
 
+    explicit _Config(const Options& options)
+        : options(options),
+          delimiter(options.delimiter),
+          counting(options.stats ? std::make_shared<detail::CountingResource>() : nullptr),
+          unorderedSections(memoryResource()),
+          orderedSections(memoryResource()),
+          listSections(memoryResource()) {}
+
    public:
-    _Config(const fs::path& filename, const std::string& delimiter) {
-        this->delimiter = delimiter;
+    _Config(const fs::path& filename, const Options& options) : _Config(options) {
         this->configFileNames.push_back(filename);
         parseAll();
     }
 
-    _Config(const std::vector<fs::path>& fileNames, const std::string& delimiter) {
-        this->delimiter = delimiter;
+    _Config(const std::vector<fs::path>& fileNames, const Options& options) : _Config(options) {
         this->configFileNames = fileNames;
         parseAll();
     }
 
-    _Config(int argc, char** argv, const std::string& delimiter) {
-        this->delimiter = delimiter;
+    _Config(int argc, char** argv, const Options& options) : _Config(options) {
         for (int i = 1; i < argc; ++i) {
             configFileNames.push_back(argv[i]);
         }
         parseAll();
     }
 
+    _Config(const fs::path& filename, const std::string& delimiter) : _Config(filename, Options{delimiter}) {}
+    _Config(const std::vector<fs::path>& fileNames, const std::string& delimiter)
+        : _Config(fileNames, Options{delimiter}) {}
+    _Config(int argc, char** argv, const std::string& delimiter) : _Config(argc, argv, Options{delimiter}) {}
+
+    // Streams the files through 'handler' instead of building a config, see EventHandler.
+    // Memory use does not depend on the size of the files. Errors are reported like by the
+    // constructors, events already delivered are not taken back.
+    static void parseEvents(const std::vector<fs::path>& fileNames, EventHandler& handler, const Options& options = Options()) {
+        for (const fs::path& filename : fileNames) {
+            errhandle::StackTrace trace;
+            std::vector<std::string> stack;
+            try{
+                streamFile(filename, trace, stack, handler, options);
+            } catch(std::exception& ex){
+                error(trace, ex.what());
+            }
+        }
+    }
+
+    // Loads the same files again. With Options::incremental only the files whose fingerprint
+    // changed since this config was loaded are read, the rest is merged from what was kept.
+    // This config is not modified, so it stays safe to read while the new one is built.
+    std::shared_ptr<_Config> refresh() const {
+        std::shared_ptr<_Config> config(new _Config(options));
+        config->configFileNames = configFileNames;
+        config->parseAll(this);
+        return config;
+    }
+
+    // drops the files kept for Options::processCache
+    static void clearProcessCache() { processCache().clear(); }
+
     // only for unordered sections
-    bool contains(const std::string& name) { return contains("", name); }
+    bool contains(std::string_view name) { return contains("", name); }
 
     // only for unordered sections
-    bool contains(const std::string& unordSec, const std::string& name) {
-        if (unorderedSections.find(unordSec) == unorderedSections.end()) return false;
-        return unorderedSections[unordSec].find(name) != unorderedSections[unordSec].end();
-    }
+    bool contains(std::string_view unordSec, std::string_view name) { return find(unordSec, name) != nullptr; }
 
-#if __cpp_lib_optional
+    // Non-throwing lookups, nullptr if the section or key does not exist. They never allocate,
+    // except for the first use of a section with Options::lazy.
 
-    std::optional<std::reference_wrapper<unordered_container>> optSection(const std::string& section) {
-        auto res = unorderedSections.find(section);
-        if (res == unorderedSections.end()) return std::nullopt;
-        return res->second;
+    unordered_container* findSection(std::string_view section) {
+        auto res = detail::find(unorderedSections, section);
+        return res == unorderedSections.end() ? nullptr : materialize(&res->second);
     }
 
-    std::optional<Value> opt(const std::string& key) { return opt("", key); }
+    Value* find(std::string_view key) { return find("", key); }
 
-    std::optional<Value> opt(const std::string& section, const std::string& key) {
-        auto sec = optSection(section);
-        if (!sec) return std::nullopt;
+    Value* find(std::string_view section, std::string_view key) {
+        unordered_container* sec = findSection(section);
+        if (!sec) return nullptr;
+        auto res = detail::find(*sec, key);
+        return res == sec->end() ? nullptr : &res->second;
+    }
 
-        auto res = sec->get().find(key);
-        if (res == sec->get().end()) return std::nullopt;
+    ordered_container* findOrderedSection(std::string_view section) {
+        auto res = detail::find(orderedSections, section);
+        return res == orderedSections.end() ? nullptr : materialize(&res->second);
+    }
 
-        return res->second;
+    Value* findOrdered(std::string_view section, std::string_view key) {
+        const ordered_container* sec = findOrderedSection(section);
+        if (!sec) return nullptr;
+        // a const lookup keeps the index: only the value is handed out, keys stay as they are
+        auto res = sec->find(key);
+        return res == sec->end() ? nullptr : const_cast<Value*>(&res->second);
     }
 
-    std::optional<std::reference_wrapper<ordered_container>> optOrderedSection(const std::string& section) {
-        auto res = orderedSections.find(section);
-        if (res == orderedSections.end()) return std::nullopt;
-        return res->second;
+    list_container* findList(std::string_view name) {
+        auto res = detail::find(listSections, name);
+        return res == listSections.end() ? nullptr : materialize(&res->second);
     }
 
-    std::optional<Value> optOrdered(const std::string& section, const std::string& key) {
-        auto sec = optOrderedSection(section);
-        if (!sec) return std::nullopt;
+#if __cpp_lib_optional
 
-        auto res = std::find_if(
-            sec->get().begin(),
-            sec->get().end(),
-            [&](auto& item) { return item.first == key; }
-        );
+    std::optional<std::reference_wrapper<unordered_container>> optSection(std::string_view section) {
+        unordered_container* res = findSection(section);
+        if (!res) return std::nullopt;
+        return *res;
+    }
+
+    std::optional<Value> opt(std::string_view key) { return opt("", key); }
 
-        if (res == sec->get().end()) return std::nullopt;
-        return res->second;
+    std::optional<Value> opt(std::string_view section, std::string_view key) {
+        Value* res = find(section, key);
+        if (!res) return std::nullopt;
+        return *res;
     }
 
-    std::optional<std::reference_wrapper<list_container>> optList(const std::string& list) {
-        auto res = listSections.find(list);
-        if (res == listSections.end()) return std::nullopt;
-        return res->second;
+    std::optional<std::reference_wrapper<ordered_container>> optOrderedSection(std::string_view section) {
+        ordered_container* res = findOrderedSection(section);
+        if (!res) return std::nullopt;
+        return *res;
+    }
+
+    std::optional<Value> optOrdered(std::string_view section, std::string_view key) {
+        Value* res = findOrdered(section, key);
+        if (!res) return std::nullopt;
+        return *res;
+    }
+
+    std::optional<std::reference_wrapper<list_container>> optList(std::string_view list) {
+        list_container* res = findList(list);
+        if (!res) return std::nullopt;
+        return *res;
     }
 
 #endif  // __cpp_lib_optional
 
-    Value& get(const std::string& key) { return get("", key); }
+    Value& get(std::string_view key) { return get("", key); }
 
-    unordered_container& getSection(const std::string& section) {
-        if (unorderedSections.find(section) == unorderedSections.end())
-            throw std::runtime_error("No such unordered section '" + section + "'");
-        return unorderedSections[section];
+    unordered_container& getSection(std::string_view section) {
+        unordered_container* res = findSection(section);
+        if (!res) throw std::runtime_error("No such unordered section '" + std::string(section) + "'");
+        return *res;
     }
 
-    Value& get(const std::string& section, const std::string& key) {
+    Value& get(std::string_view section, std::string_view key) {
         unordered_container& sectionMap = getSection(section);
-        if (sectionMap.find(key) == sectionMap.end())
-            throw std::runtime_error("'" + key + "' not found in unordered section '" + section + "'");
-        return sectionMap[key];
+        auto it = detail::find(sectionMap, key);
+        if (it == sectionMap.end())
+            throw std::runtime_error("'" + std::string(key) + "' not found in unordered section '" + std::string(section) + "'");
+        return it->second;
     }
 
-    ordered_container& getOrderedSection(const std::string& section) {
-        if (orderedSections.find(section) == orderedSections.end())
-            throw std::runtime_error("No such ordered section '" + section + "'");
-        return orderedSections[section];
+    ordered_container& getOrderedSection(std::string_view section) {
+        ordered_container* res = findOrderedSection(section);
+        if (!res) throw std::runtime_error("No such ordered section '" + std::string(section) + "'");
+        return *res;
     }
 
-    Value& getOrdered(const std::string& section, const std::string& key) {
-        ordered_container& sectionMap = getOrderedSection(section);
-        ordered_container::iterator it;
-        it = find_if(sectionMap.begin(), sectionMap.end(), [key](std::pair<std::string, Value>& p) {
-            return p.first == key;
-        });
+    Value& getOrdered(std::string_view section, std::string_view key) {
+        const ordered_container& sectionMap = getOrderedSection(section);
+        auto it = sectionMap.find(key);
         if (it == sectionMap.end())
-            throw std::runtime_error("'" + key + "' not found in ordered section '" + section + "'");
-        return it->second;
+            throw std::runtime_error("'" + std::string(key) + "' not found in ordered section '" + std::string(section) + "'");
+        return const_cast<Value&>(it->second);  // as in findOrdered()
     }
-    list_container& getList(const std::string& name) {
-        std::unordered_map<std::string, list_container>::iterator it = listSections.find(name);
-        if (it == listSections.end()) throw std::runtime_error("No such list section '" + name + "'");
-        return it->second;
+    list_container& getList(std::string_view name) {
+        list_container* res = findList(name);
+        if (!res) throw std::runtime_error("No such list section '" + std::string(name) + "'");
+        return *res;
+    }
+
+    // false if the list does not exist or has no such item
+    bool containsInList(std::string_view name, std::string_view item) {
+        list_container* list = findList(name);
+        return list && list->contains(item);
+    }
+
+    // every item of a list converted to T, throws naming the first item that does not convert
+    template <class T>
+    std::vector<T> getListAs(std::string_view name) {
+        const list_container& list = getList(name);
+        std::vector<T> res;
+        size_t failed = list.decode(res);
+        if (failed != list.size())
+            throw std::runtime_error(
+                "Can not cast item " + std::to_string(failed) + " of list section '" + std::string(name) + "' to " +
+                Value::typeName<T>() + ": '" + list[failed].value + "'"
+            );
+        return res;
+    }
+
+    // converts every value of an unordered section up front, typed reads are then plain loads
+    void cacheTypes(std::string_view section) {
+        for (const auto& [key, value] : getSection(section)) value.cacheTypes();
     }
 
     std::vector<fs::path> getConfigFileNames() { return configFileNames; }
     std::string getConfigFileName() { return configFileNames[configFileNames.size() - 1]; }
+    std::vector<fs::path> getParsedFileNames() { return parsedFileNames; }
+    const Options& getOptions() { return options; }
+    // nullptr without Options::stats
+    const LoadStats* getLoadStats() const { return stats.get(); }
+
+    unordered_container& getMainSection() { return *materialize(&unorderedSections[""]); }
+    // with Options::lazy these tokenize every section that was not used yet
+    section_map<ordered_container>& getAllOrdered() { materializeAll(); return orderedSections; }
+    section_map<unordered_container>& getAllUnordered() { materializeAll(); return unorderedSections; }
+    section_map<list_container>& getAllLists() { materializeAll(); return listSections; }
+
+    // compiles the current contents into an immutable snapshot for lock-free concurrent reads
+    std::shared_ptr<const FrozenConfig> freeze() const {
+        const_cast<_Config*>(this)->materializeAll();
+        return std::make_shared<const FrozenConfig>(unorderedSections, orderedSections, listSections);
+    }
 
-    unordered_container& getMainSection() { return unorderedSections[""]; }
-    std::unordered_map<std::string, ordered_container>& getAllOrdered() { return orderedSections; }
-    std::unordered_map<std::string, unordered_container>& getAllUnordered() { return unorderedSections; }
-    std::unordered_map<std::string, list_container>& getAllLists() { return listSections; }
+    // Writes the merged sections as a binary image that CompiledConfig maps. The image is written
+    // to a temporary file renamed over 'path', so processes that have the old image mapped keep it.
+    void compile(const fs::path& path) const {
+        const_cast<_Config*>(this)->materializeAll();
+        std::string data = image::build(unorderedSections, orderedSections, listSections);
+        fs::path tmp = path;
+        tmp += ".tmp";
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        out.close();
+        if (out.fail()) throw std::runtime_error("can not write file '" + tmp.string() + "'");
+        fs::rename(tmp, path);
+    }
 
-    std::string dump() {
-        std::stringstream ss;
+    // Writes the config back as text: the main section, then the unordered, ordered and list
+    // sections. Reading the result with the same delimiter gives the same config.
+    std::string dump(const DumpOptions& dumpOptions = DumpOptions()) {
+        Dumper dumper(*this, dumpOptions);
+        std::string res;
+        res.reserve(dumper.size());
+        dumper.write([&](std::string_view s) { res.append(s); });
+        return res;
+    }
+
+    // Writes into 'buffer' if the text fits into 'size' bytes. Returns the size of the text
+    // either way, no terminating zero is written.
+    size_t dump(char* buffer, size_t size, const DumpOptions& dumpOptions = DumpOptions()) {
+        Dumper dumper(*this, dumpOptions);
+        size_t res = dumper.size();
+        if (res > size) return res;
+        dumper.write([&](std::string_view s) {
+            memcpy(buffer, s.data(), s.length());
+            buffer += s.length();
+        });
+        return res;
+    }
 
-        unordered_container& mainSection = getMainSection();
-        ss << strutils::to_string(mainSection);
+    void dump(std::ostream& out, const DumpOptions& dumpOptions = DumpOptions()) {
+        Dumper dumper(*this, dumpOptions);
+        dumper.write([&](std::string_view s) { out.write(s.data(), s.length()); });
+    }
+
+    // size of the text dump() writes
+    size_t dumpSize(const DumpOptions& dumpOptions = DumpOptions()) { return Dumper(*this, dumpOptions).size(); }
+
+#if CFGPARSER_HAS_UNISTD
+    // writes through a buffer of 64 KiB, throws if a write fails
+    void dump(int fd, const DumpOptions& dumpOptions = DumpOptions()) {
+        Dumper dumper(*this, dumpOptions);
+        std::string buffer;
+        buffer.reserve(1 << 16);
+        auto flush = [&] {
+            const char* data = buffer.data();
+            size_t left = buffer.size();
+            while (left > 0) {
+                ssize_t n = ::write(fd, data, left);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    throw std::runtime_error("can not write config dump: " + std::string(strerror(errno)));
+                }
+                data += n;
+                left -= n;
+            }
+            buffer.clear();
+        };
+        dumper.write([&](std::string_view s) {
+            if (buffer.size() + s.length() > buffer.capacity()) flush();
+            if (s.length() >= buffer.capacity()) {
+                buffer = s;
+                flush();
+                return;
+            }
+            buffer.append(s);
+        });
+        flush();
+    }
+#endif  // CFGPARSER_HAS_UNISTD
+
+   private:
+    // The sections in the order dump() writes them, sorted once if asked to, and the size of the
+    // text. write() hands the text to 'out' piece by piece.
+    class Dumper {
+       public:
+        Dumper(_Config& config, const DumpOptions& dumpOptions)
+            : delimiter(dumpOptions.delimiter.empty() ? config.delimiter : dumpOptions.delimiter),
+              sorted(dumpOptions.sorted) {
+            config.materializeAll();
+            // the main section is the one without a name, it is written without a header
+            for (const auto& [name, section] : config.unorderedSections) {
+                if (name.empty()) main = entries(section);
+                else unordered.push_back({name, entries(section)});
+                if (!name.empty()) total += name.length() + 3;
+            }
+            for (const auto& section : config.orderedSections) {
+                ordered.push_back(&section);
+                total += section.first.length() + 3;
+                for (const auto& [key, value] : section.second) total += key.length() + delimiter.length() + value.value.length() + 1;
+            }
+            for (const auto& section : config.listSections) {
+                lists.push_back(&section);
+                total += section.first.length() + 3;
+                for (const Value& item : section.second) total += item.value.length() + 1;
+            }
+            if (!sorted) return;
+            auto byName = [](const auto& a, const auto& b) { return a.first < b.first; };
+            auto byNamePtr = [](const auto* a, const auto* b) { return a->first < b->first; };
+            std::sort(unordered.begin(), unordered.end(), byName);
+            std::sort(ordered.begin(), ordered.end(), byNamePtr);
+            std::sort(lists.begin(), lists.end(), byNamePtr);
+        }
+
+        size_t size() const { return total; }
 
-        for (auto section = unorderedSections.begin(); section != unorderedSections.end(); ++section) {
-            if (section->second == mainSection) continue;
-            ss << "[" << section->first << "]" << std::endl;
-            ss << strutils::to_string(section->second);
+        template <class Out>
+        void write(Out&& out) const {
+            for (const Entry* entry : main) writeEntry(entry->first, entry->second, out);
+            for (const auto& [name, entries] : unordered) {
+                writeHeader('[', name, ']', out);
+                for (const Entry* entry : entries) writeEntry(entry->first, entry->second, out);
+            }
+            for (const auto* section : ordered) {
+                writeHeader('<', section->first, '>', out);
+                for (const auto& [key, value] : section->second) writeEntry(key, value, out);
+            }
+            for (const auto* section : lists) {
+                writeHeader('{', section->first, '}', out);
+                for (const Value& item : section->second) {
+                    out(item.value);
+                    out("\n");
+                }
+            }
         }
 
-        for (auto section = orderedSections.begin(); section != orderedSections.end(); ++section) {
-            ss << "<" << section->first << ">" << std::endl;
-            ss << strutils::to_string(section->second);
+       private:
+        using Entry = std::pair<const std::string, Value>;
+
+        std::string delimiter;
+        bool sorted;
+        size_t total = 0;  // bytes write() hands out
+        std::vector<const Entry*> main;
+        std::vector<std::pair<std::string_view, std::vector<const Entry*>>> unordered;
+        std::vector<const std::pair<const std::string, ordered_container>*> ordered;
+        std::vector<const std::pair<const std::string, list_container>*> lists;
+
+        template <class Out>
+        static void writeHeader(char open, std::string_view name, char close, Out& out) {
+            out(std::string_view(&open, 1));
+            out(name);
+            out(std::string_view(&close, 1));
+            out("\n");
         }
 
-        for (auto section = listSections.begin(); section != listSections.end(); ++section) {
-            ss << "{" << section->first << "}" << std::endl;
-            ss << strutils::to_string(section->second);
+        template <class Out>
+        void writeEntry(std::string_view key, const Value& value, Out& out) const {
+            out(key);
+            out(delimiter);
+            out(value.value);
+            out("\n");
         }
 
-        return ss.str();
-    }
+        // entries of an unordered section in the order they are written
+        std::vector<const Entry*> entries(const unordered_container& section) {
+            std::vector<const Entry*> res;
+            res.reserve(section.size());
+            for (const Entry& entry : section) {
+                res.push_back(&entry);
+                total += entry.first.length() + delimiter.length() + entry.second.value.length() + 1;
+            }
+            if (sorted) std::sort(res.begin(), res.end(), [](const Entry* a, const Entry* b) { return a->first < b->first; });
+            return res;
+        }
+    };
 };
 
 class Config : protected std::shared_ptr<_Config> {
@@ -522,30 +3458,405 @@ class Config : protected std::shared_ptr<_Config> {
         : std::shared_ptr<_Config>(new _Config(std::vector<fs::path>(filenames.begin(), filenames.end()), delimiter)) {}
     Config(int argc, char** argv, const std::string& delimiter = defaultDelimiter)
         : std::shared_ptr<_Config>(new _Config(argc, argv, delimiter)) {}
+    Config(const fs::path& filename, const Options& options)
+        : std::shared_ptr<_Config>(new _Config(filename, options)) {}
+    Config(const std::vector<fs::path>& filenames, const Options& options)
+        : std::shared_ptr<_Config>(new _Config(filenames, options)) {}
+    Config(const std::vector<std::string>& filenames, const Options& options)
+        : std::shared_ptr<_Config>(new _Config(std::vector<fs::path>(filenames.begin(), filenames.end()), options)) {}
+    Config(int argc, char** argv, const Options& options) : std::shared_ptr<_Config>(new _Config(argc, argv, options)) {}
+
+    explicit Config(std::shared_ptr<_Config> config) : std::shared_ptr<_Config>(std::move(config)) {}
 
     operator bool() { return std::shared_ptr<_Config>::operator bool(); }
     _Config* operator->() { return std::shared_ptr<_Config>::operator->(); }
+
+   private:
+    friend void publishConfig(Config config);
+};
+
+namespace detail {
+
+template <class Key, class = void>
+struct hasDefault : std::false_type {};
+template <class Key>
+struct hasDefault<Key, std::void_t<decltype(Key::defaultValue)>> : std::true_type {};
+
+// position of Key in Keys, sizeof...(Keys) if it is not there
+template <class Key, class... Keys>
+constexpr size_t indexOf() {
+    constexpr std::array<bool, sizeof...(Keys)> matches{std::is_same_v<Key, Keys>...};
+    for (size_t i = 0; i < matches.size(); ++i)
+        if (matches[i]) return i;
+    return matches.size();
+}
+
+template <class... Keys>
+constexpr bool distinctKeys() {
+    constexpr std::array<std::string_view, sizeof...(Keys)> sections{Keys::section...};
+    constexpr std::array<std::string_view, sizeof...(Keys)> keys{Keys::key...};
+    for (size_t i = 0; i < keys.size(); ++i)
+        for (size_t j = i + 1; j < keys.size(); ++j)
+            if (sections[i] == sections[j] && keys[i] == keys[j]) return false;
+    return true;
+}
+
+}  // namespace detail
+
+// passed to the Schema constructor, keys of the schema's sections it does not declare are errors too
+struct StrictSchema {};
+inline constexpr StrictSchema strictSchema{};
+
+// Typed keys declared at compile time. Every key is a struct naming its unordered section ("" for
+// the main one), its key, the C++ type of its value and optionally a default:
+//
+//     struct db_port {
+//         static constexpr std::string_view section = "DatabaseConnection";
+//         static constexpr std::string_view key = "db_port";
+//         using type = int;
+//         static constexpr int defaultValue = 5432;
+//     };
+//
+// The constructor reads and converts every key once and throws one exception listing all keys
+// that are missing (without a default) or do not convert; with strictSchema also the keys present
+// in a section of the schema without being declared. get<db_port>() then returns the stored
+// value, no lookup or parsing.
+template <class... Keys>
+class Schema {
+    static_assert(detail::distinctKeys<Keys...>(), "a key is declared twice");
+
+   public:
+    explicit Schema(_Config& config) { load(config, false, std::index_sequence_for<Keys...>()); }
+    explicit Schema(Config config) : Schema(*config.operator->()) {}
+    Schema(_Config& config, StrictSchema) { load(config, true, std::index_sequence_for<Keys...>()); }
+    Schema(Config config, StrictSchema strict) : Schema(*config.operator->(), strict) {}
+
+    template <class Key>
+    const typename Key::type& get() const {
+        constexpr size_t index = detail::indexOf<Key, Keys...>();
+        static_assert(index < sizeof...(Keys), "the key is not part of this schema");
+        return std::get<index>(values);
+    }
+
+   private:
+    std::tuple<typename Keys::type...> values;
+
+    template <size_t... I>
+    void load(_Config& config, bool strict, std::index_sequence<I...>) {
+        std::vector<std::string> problems;
+        (read<Keys>(config, std::get<I>(values), problems), ...);
+        if (strict) unknownKeys(config, problems);
+
+        if (problems.empty()) return;
+        std::string message = "Config schema:";
+        for (const std::string& problem : problems) message += "\n" + problem;
+        throw std::runtime_error(message);
+    }
+
+    static void unknownKeys(_Config& config, std::vector<std::string>& problems) {
+        std::vector<std::string> unknown;
+        constexpr std::array<std::string_view, sizeof...(Keys)> sections{Keys::section...};
+        for (size_t i = 0; i < sections.size(); ++i) {
+            if (std::find(sections.begin(), sections.begin() + i, sections[i]) != sections.begin() + i) continue;
+            unordered_container* section = config.findSection(sections[i]);
+            if (!section) continue;
+            for (const auto& [key, value] : *section) {
+                if (((Keys::section == sections[i] && Keys::key == key) || ...)) continue;
+                unknown.push_back("unknown key '" + std::string(key) + "' in section '" + std::string(sections[i]) + "'");
+            }
+        }
+        // sections iterate in hash order
+        std::sort(unknown.begin(), unknown.end());
+        problems.insert(problems.end(), unknown.begin(), unknown.end());
+    }
+
+    template <class Key>
+    static void read(_Config& config, typename Key::type& out, std::vector<std::string>& problems) {
+        Value* value = config.find(Key::section, Key::key);
+        if (!value) {
+            if constexpr (detail::hasDefault<Key>::value) out = typename Key::type(Key::defaultValue);
+            else problems.push_back("missing key '" + std::string(Key::key) + "' in section '" + std::string(Key::section) + "'");
+            return;
+        }
+        if (!value->tryAs(out))
+            problems.push_back(
+                "can not cast '" + std::string(Key::key) + "' in section '" + std::string(Key::section) + "' to " +
+                Value::typeName<typename Key::type>() + ": '" + value->value + "'"
+            );
+    }
+};
+
+namespace detail {
+
+// Holder of the global config. Writers swap in a whole new _Config, readers copy the current
+// pointer and keep that snapshot alive for as long as they use it. Readers never wait: they
+// announce themselves in the reader count of the current epoch, copy the pointer and leave. A
+// writer swaps the pointer, moves on to the next epoch and waits until the readers of the
+// previous one are gone before it frees the holder they may have been copying from.
+class ConfigSlot {
+   public:
+    ConfigSlot() = default;
+    ConfigSlot(const ConfigSlot&) = delete;
+    ConfigSlot& operator=(const ConfigSlot&) = delete;
+    ~ConfigSlot() { delete current.load(); }
+
+    std::shared_ptr<_Config> load() const {
+        uint64_t e = epoch.load();
+        // retried only if a store() moved on between the two loads of 'epoch'
+        while (true) {
+            readers[e & 1].fetch_add(1);
+            uint64_t now = epoch.load();
+            if (now == e) break;
+            readers[e & 1].fetch_sub(1);
+            e = now;
+        }
+        const Holder* holder = current.load();
+        std::shared_ptr<_Config> res = holder ? holder->config : nullptr;
+        readers[e & 1].fetch_sub(1);
+        return res;
+    }
+
+    void store(std::shared_ptr<_Config> next) {
+        std::unique_ptr<Holder> previous;
+        {
+            std::lock_guard<std::mutex> lock(writer);
+            previous.reset(current.exchange(new Holder{std::move(next)}));
+            uint64_t e = epoch.fetch_add(1);
+            // readers that started after the increment see the new holder
+            while (readers[e & 1].load() != 0) std::this_thread::yield();
+        }
+        generation.fetch_add(1, std::memory_order_release);
+        // the previous config is released here, outside of the lock
+    }
+
+    // changes after every store(), a reader that saw the new generation gets the new pointer from load()
+    uint64_t currentGeneration() const { return generation.load(std::memory_order_acquire); }
+
+   private:
+    struct Holder {
+        std::shared_ptr<_Config> config;
+    };
+
+    std::atomic<Holder*> current{nullptr};
+    std::atomic<uint64_t> epoch{0};
+    mutable std::atomic<uint64_t> readers[2] = {0, 0};
+    std::mutex writer;
+    // own cache line: it is only written on publish, readers polling it never share a line with
+    // the state above
+    alignas(64) std::atomic<uint64_t> generation{1};
+};
+
+// per-thread copy of the global config pointer, refreshed when the generation changes
+struct ReaderCache {
+    uint64_t generation = 0;
+    std::shared_ptr<_Config> config;
 };
 
-inline Config _globalConfig;
+}  // namespace detail
+
+inline void parseEvents(const fs::path& filename, EventHandler& handler, const Options& options = Options()) {
+    _Config::parseEvents({filename}, handler, options);
+}
+inline void parseEvents(const std::vector<fs::path>& filenames, EventHandler& handler, const Options& options = Options()) {
+    _Config::parseEvents(filenames, handler, options);
+}
+
+inline detail::ConfigSlot _globalConfig;
+
+// replaces the global config, threads that already hold the previous one keep using it
+inline void publishConfig(Config config) { _globalConfig.store(std::move(config)); }
 
 inline void initConfig(const fs::path& filename, const std::string& delimiter = defaultDelimiter) {
-    _globalConfig = Config(filename, delimiter);
+    publishConfig(Config(filename, delimiter));
 }
 inline void initConfig(const std::vector<fs::path>& filenames, const std::string& delimiter = defaultDelimiter) {
-    _globalConfig = Config(filenames, delimiter);
+    publishConfig(Config(filenames, delimiter));
 }
 inline void initConfig(const std::vector<std::string>& filenames, const std::string& delimiter = defaultDelimiter) {
-    _globalConfig = Config(std::vector<fs::path>(filenames.begin(), filenames.end()), delimiter);
+    publishConfig(Config(std::vector<fs::path>(filenames.begin(), filenames.end()), delimiter));
 }
 inline void initConfig(int argc, char** argv, const std::string& delimiter = defaultDelimiter) {
-    _globalConfig = Config(argc, argv, delimiter);
+    publishConfig(Config(argc, argv, delimiter));
+}
+inline void initConfig(const fs::path& filename, const Options& options) { publishConfig(Config(filename, options)); }
+inline void initConfig(const std::vector<fs::path>& filenames, const Options& options) {
+    publishConfig(Config(filenames, options));
+}
+inline void initConfig(const std::vector<std::string>& filenames, const Options& options) {
+    publishConfig(Config(std::vector<fs::path>(filenames.begin(), filenames.end()), options));
+}
+inline void initConfig(int argc, char** argv, const Options& options) { publishConfig(Config(argc, argv, options)); }
+
+// Loads a config on a thread of its own, takes the arguments of the Config constructors. The future
+// holds the config or what the constructor threw. Options::ioThreads reads the includes ahead.
+template <class... Args>
+std::future<Config> loadConfigAsync(Args&&... args) {
+    return std::async(
+        std::launch::async, [](std::decay_t<Args>... args) { return Config(std::move(args)...); }, std::forward<Args>(args)...
+    );
+}
+
+// initConfig() on a thread of its own, the future is ready once the config is published
+template <class... Args>
+std::future<void> initConfigAsync(Args&&... args) {
+    return std::async(
+        std::launch::async, [](std::decay_t<Args>... args) { publishConfig(Config(std::move(args)...)); }, std::forward<Args>(args)...
+    );
 }
 
 inline Config getConfig() {
-    if (!_globalConfig) throw std::runtime_error("Global config parser is not initialized");
-    return _globalConfig;
+    Config config(_globalConfig.load());
+    if (!config) throw std::runtime_error("Global config parser is not initialized");
+    return config;
+}
+
+// Borrowed access to the global config for hot paths. Each thread keeps its own reference to the
+// current config and only checks a generation counter, so steady-state reads write no shared memory
+// (getConfig() increments the shared reference count on every call). The returned reference stays
+// valid until the same thread calls readConfig() again after a new config was published; an idle
+// thread keeps the config it last read alive.
+inline _Config& readConfig() {
+    thread_local detail::ReaderCache cache;
+    uint64_t generation = _globalConfig.currentGeneration();
+    if (cache.generation != generation) {
+        cache.config = _globalConfig.load();
+        cache.generation = generation;
+    }
+    if (!cache.config) throw std::runtime_error("Global config parser is not initialized");
+    return *cache.config;
+}
+
+// Parses the files of the global config again with the same options and publishes the result,
+// see _Config::refresh().
+// If parsing fails the exception is passed on and the current config stays in place.
+inline void reloadConfig() {
+    Config current = getConfig();
+    publishConfig(Config(current->refresh()));
 }
+
+#if CFGPARSER_HAS_INOTIFY
+
+// Reloads the global config when one of the files it was read from (including !include'd ones)
+// is written, replaced or removed. Changes are debounced: the reload starts once no further
+// events arrived for 'debounce'. Reload errors go to 'onError', the old config stays published.
+class ConfigWatcher {
+   public:
+    explicit ConfigWatcher(
+        std::chrono::milliseconds debounce = std::chrono::milliseconds(200),
+        std::function<void(const std::exception&)> onError = nullptr
+    )
+        : debounce(debounce), onError(std::move(onError)) {
+        // throws if nothing is published yet, before there is anything to close
+        Config config = getConfig();
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0) throw std::runtime_error("inotify_init1: " + std::string(strerror(errno)));
+        if (pipe2(stopPipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+            int err = errno;
+            ::close(inotifyFd);
+            throw std::runtime_error("pipe2: " + std::string(strerror(err)));
+        }
+        try {
+            watchFiles(std::move(config));
+            thread = std::thread([this] { run(); });
+        } catch (...) {
+            // the destructor does not run for a constructor that throws
+            closeAll();
+            throw;
+        }
+    }
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    ~ConfigWatcher() {
+        char byte = 0;
+        while (::write(stopPipe[1], &byte, 1) < 0 && errno == EINTR) {}
+        thread.join();
+        closeAll();
+    }
+
+   private:
+    std::chrono::milliseconds debounce;
+    std::function<void(const std::exception&)> onError;
+    int inotifyFd = -1;
+    int stopPipe[2] = {-1, -1};
+    std::thread thread;
+    // watch descriptor -> directory, files are watched through their directories so that
+    // editors replacing a file by rename are noticed too
+    std::unordered_map<int, fs::path> directories;
+    std::vector<fs::path> files;
+
+    void closeAll() {
+        ::close(inotifyFd);
+        ::close(stopPipe[0]);
+        ::close(stopPipe[1]);
+    }
+
+    void watchFiles(Config config) {
+        for (const auto& [wd, dir] : directories) inotify_rm_watch(inotifyFd, wd);
+        directories.clear();
+        files = config->getParsedFileNames();
+        for (const fs::path& file : files) {
+            fs::path dir = file.parent_path();
+            int wd = inotify_add_watch(
+                inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB
+            );
+            if (wd >= 0) directories[wd] = dir;
+        }
+    }
+
+    // drains pending events, true if one of them touched a watched file
+    bool readEvents() {
+        alignas(inotify_event) char buf[4096];
+        bool relevant = false;
+        ssize_t n;
+        while ((n = ::read(inotifyFd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + n;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+                auto dir = directories.find(event->wd);
+                if (dir == directories.end() || event->len == 0) continue;
+                fs::path changed = dir->second / event->name;
+                relevant |= std::find(files.begin(), files.end(), changed) != files.end();
+            }
+        }
+        return relevant;
+    }
+
+    void run() {
+        bool pending = false;
+        std::chrono::steady_clock::time_point deadline;
+        while (true) {
+            int timeout = -1;
+            if (pending) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                timeout = std::max<long long>(0, left.count());
+            }
+            pollfd fds[2] = {{stopPipe[0], POLLIN, 0}, {inotifyFd, POLLIN, 0}};
+            int res = ::poll(fds, 2, timeout);
+            if (res < 0 && errno != EINTR) return;
+            if (fds[0].revents) return;
+            if (fds[1].revents && readEvents()) {
+                pending = true;
+                deadline = std::chrono::steady_clock::now() + debounce;
+                continue;
+            }
+            if (pending && std::chrono::steady_clock::now() >= deadline) {
+                pending = false;
+                try {
+                    reloadConfig();
+                } catch (const std::exception& ex) {
+                    if (onError) onError(ex);
+                }
+                // includes may have been added or removed
+                watchFiles(getConfig());
+            }
+        }
+    }
+};
+
+#endif  // CFGPARSER_HAS_INOTIFY
+
 }  // namespace cfgparser
 
 #endif
\ No newline at end of file
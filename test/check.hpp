@@ -0,0 +1,35 @@
+// Helpers shared by the tests: every test is a program taking a scratch directory and failing
+// with a message on the first CHECK that does not hold.
+#ifndef CFGPARSER_TEST_CHECK_HPP
+#define CFGPARSER_TEST_CHECK_HPP
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#define CHECK(cond)                                                                               \
+    do {                                                                                          \
+        if (!(cond)) {                                                                            \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; \
+            std::exit(1);                                                                         \
+        }                                                                                         \
+    } while (0)
+
+// message of what 'f' throws, empty if it does not
+template <class F>
+std::string thrown(F&& f) {
+    try {
+        f();
+    } catch (const std::exception& ex) {
+        return ex.what();
+    }
+    return "";
+}
+
+inline std::filesystem::path writeFile(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream(path) << text;
+    return path;
+}
+
+#endif
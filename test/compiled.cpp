@@ -0,0 +1,134 @@
+// CompiledConfig reads back what compile() wrote and refuses truncated or damaged images with an
+// exception, whether the checksum is verified or not.
+#include "cfg_parser.hpp"
+
+#include <set>
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+static std::string readFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// every section and value of 'config', as read from 'image'
+static void checkSame(cfgparser::Config& config, const cfgparser::CompiledConfig& image) {
+    size_t entries = 0;
+    for (const auto& [section, values] : config->getAllUnordered()) {
+        for (const auto& [key, value] : values) CHECK(image.get(section, key) == value.value);
+        entries += values.size();
+    }
+    for (const auto& [section, values] : config->getAllOrdered()) {
+        cfgparser::CompiledConfig::OrderedSection compiled = image.getOrderedSection(section);
+        CHECK(compiled.size() == values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            CHECK(compiled[i].first == values[i].first);
+            CHECK(compiled[i].second == values[i].second.value);
+            std::string_view first;
+            CHECK(image.findOrdered(section, values[i].first, first));
+            CHECK(first == config->getOrdered(section, values[i].first).value);
+        }
+        std::set<std::string_view> keys;
+        for (const auto& [key, value] : values) keys.insert(key);
+        entries += keys.size();
+    }
+    for (const auto& [section, values] : config->getAllLists()) {
+        cfgparser::CompiledConfig::ListSection compiled = image.getList(section);
+        CHECK(compiled.size() == values.size());
+        for (size_t i = 0; i < values.size(); ++i) CHECK(compiled[i] == values[i].value);
+    }
+    CHECK(image.size() == entries);
+    std::string_view value;
+    CHECK(!image.find("db", "missing", value));
+    CHECK(!image.findOrdered("db", "host", value));
+    CHECK(thrown([&] { image.getList("db"); }) == "No such list section 'db'");
+}
+
+// every lookup 'image' answers, exceptions included, without reading outside the file
+static void readAll(cfgparser::Config& config, const cfgparser::CompiledConfig& image) {
+    auto attempt = [](auto&& f) {
+        try {
+            f();
+        } catch (const std::runtime_error&) {
+        }
+    };
+    for (const auto& [section, values] : config->getAllUnordered())
+        for (const auto& [key, value] : values) attempt([&] { image.get(section, key).size(); });
+    for (const auto& [section, values] : config->getAllOrdered())
+        attempt([&] {
+            for (const auto& [key, value] : image.getOrderedSection(section)) image.getOrdered(section, key).size();
+        });
+    for (const auto& [section, values] : config->getAllLists())
+        attempt([&] {
+            for (std::string_view value : image.getList(section)) value.size();
+        });
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+    fs::path root = writeFile(
+        dir / "root.cfg",
+        "name = service\nempty = \n[db]\nhost = localhost\nport = 5432\nuser = localhost\n"
+        "[cache]\nhost = localhost\nsize = 64\n<routes>\n/a = 1\n/b = 2\n/a = 3\n<none>\n"
+        "{servers}\nalpha\nbeta\nalpha\n{nothing}\n"
+    );
+    cfgparser::Config config(root);
+    fs::path path = dir / "root.cfgimg";
+    config->compile(path);
+
+    // round trip
+    for (bool verify : {true, false}) {
+        cfgparser::CompiledConfig image(path, verify);
+        checkSame(config, image);
+    }
+    CHECK(cfgparser::CompiledConfig(path).getOrdered("routes", "/a") == "1");
+
+    const std::string written = readFile(path);
+    fs::path damaged = dir / "damaged.cfgimg";
+
+    // truncated anywhere, including inside the header
+    for (size_t size = 0; size < written.size(); ++size) {
+        writeFile(damaged, written.substr(0, size));
+        for (bool verify : {true, false}) {
+            std::string error = thrown([&] { cfgparser::CompiledConfig image(damaged, verify); });
+            CHECK(error == "Config image '" + damaged.string() + "': " + (size < sizeof(cfgparser::image::Header) ? "file too short" : "truncated"));
+        }
+    }
+
+    // Every byte changed in turn, to a high and a low value: the checksum rejects all changes
+    // after the header, without it lookups throw or answer but stay inside the file.
+    for (size_t i = 0; i < written.size(); ++i) {
+        for (char byte : {'\xff', '\x01'}) {
+            if (written[i] == byte) continue;
+            std::string text = written;
+            text[i] = byte;
+            writeFile(damaged, text);
+            std::string error = thrown([&] { cfgparser::CompiledConfig image(damaged); });
+            if (i >= sizeof(cfgparser::image::Header)) CHECK(error == "Config image '" + damaged.string() + "': checksum mismatch");
+            try {
+                cfgparser::CompiledConfig image(damaged, false);
+                readAll(config, image);
+            } catch (const std::runtime_error& ex) {
+                CHECK(std::string(ex.what()).find("Config image '") == 0);
+            }
+        }
+    }
+
+    // a string reference far outside the string area
+    std::string text = written;
+    cfgparser::image::Header header;
+    memcpy(&header, text.data(), sizeof(header));
+    for (uint64_t i = 0; i < header.entries.size; ++i) {
+        cfgparser::image::Entry entry;
+        uint64_t offset = header.entries.records + i * sizeof(entry);
+        memcpy(&entry, &text[offset], sizeof(entry));
+        entry.value.offset = uint64_t(1) << 60;
+        memcpy(&text[offset], &entry, sizeof(entry));
+    }
+    writeFile(damaged, text);
+    cfgparser::CompiledConfig image(damaged, false);
+    CHECK(thrown([&] { image.get("db", "host"); }) == "Config image '" + damaged.string() + "': bad string");
+    return 0;
+}
@@ -0,0 +1,116 @@
+// dump() writes text that loads back into the same config, through every output it supports.
+#include "cfg_parser.hpp"
+
+#include <cstdio>
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+static std::string readFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static std::string sorted(cfgparser::Config& config, const std::string& delimiter = "") {
+    cfgparser::DumpOptions options;
+    options.sorted = true;
+    options.delimiter = delimiter;
+    return config->dump(options);
+}
+
+// 'config' dumped by every overload, loaded back with 'options' and compared section by section
+static void roundTrip(cfgparser::Config& config, const fs::path& dir, const cfgparser::Options& options) {
+    cfgparser::DumpOptions dumpOptions;
+    dumpOptions.delimiter = options.delimiter;
+    const std::string text = config->dump(dumpOptions);
+    CHECK(config->dumpSize(dumpOptions) == text.size());
+
+    std::ostringstream out;
+    config->dump(out, dumpOptions);
+    CHECK(out.str() == text);
+
+    std::string buffer(text.size() + 8, '\0');
+    CHECK(config->dump(buffer.data(), text.size() - 1, dumpOptions) == text.size());
+    CHECK(buffer == std::string(text.size() + 8, '\0'));  // too small: nothing written
+    CHECK(config->dump(buffer.data(), buffer.size(), dumpOptions) == text.size());
+    CHECK(buffer.substr(0, text.size()) == text);
+
+    fs::path path = dir / "dump.cfg";
+#if CFGPARSER_HAS_UNISTD
+    FILE* file = fopen(path.c_str(), "w");
+    config->dump(fileno(file), dumpOptions);
+    fclose(file);
+    CHECK(readFile(path) == text);
+#else
+    writeFile(path, text);
+#endif
+
+    cfgparser::Config loaded(path, options);
+    CHECK(sorted(loaded) == sorted(config, options.delimiter));
+    CHECK(loaded->getAllUnordered() == config->getAllUnordered());
+    CHECK(loaded->getAllOrdered() == config->getAllOrdered());
+    CHECK(loaded->getAllLists() == config->getAllLists());
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+    writeFile(dir / "part.cfg", "[db]\nhost = included\n<order>\nfirst = 0\n{hosts}\nlost\n");
+    fs::path root = writeFile(
+        dir / "root.cfg",
+        "name = service\n"
+        "empty = \n"
+        "!include part.cfg\n"
+        "[db]\n"
+        "host = localhost\n"
+        "url = postgres://u@h/db?opt=1 = not a delimiter\n"
+        "path = C:\\dir\\file # not a comment\n"
+        "spaced key = value with  two  spaces\n"
+        "[empty section]\n"
+        "<order>\n"
+        "b = 2\n"
+        "a = 1\n"
+        "b = 3\n"
+        "<empty ordered>\n"
+        "{hosts}\n"
+        "alpha\n"
+        "beta = gamma\n"
+        "alpha\n"
+        "{empty list}\n"
+        "[db]\n"
+        "port = 5432\n"
+    );
+
+    cfgparser::Options options;
+    cfgparser::Config config(root, options);
+    CHECK(config->getOrderedSection("order").size() == 3);
+    CHECK(config->getList("hosts").size() == 3);
+    CHECK(config->get("db", "url").value == "postgres://u@h/db?opt=1 = not a delimiter");
+    roundTrip(config, dir, options);
+
+    // a custom delimiter, written back by default and replaced by DumpOptions::delimiter
+    cfgparser::Options colon;
+    colon.delimiter = ": ";
+    fs::path custom = writeFile(dir / "custom.cfg", "[s]\nkey: value = with equals\n<o>\nz: 1\ny: 2\n{l}\nitem: not split\n");
+    cfgparser::Config customConfig(custom, colon);
+    CHECK(customConfig->dump().find("key: value = with equals\n") != std::string::npos);
+    roundTrip(customConfig, dir, colon);
+    cfgparser::Options equals;
+    roundTrip(customConfig, dir, equals);
+
+    // lazy configs dump what an eager load of the same files dumps
+    cfgparser::Options lazy;
+    lazy.lazy = true;
+    cfgparser::Config lazyConfig(root, lazy);
+    CHECK(lazyConfig->get("db", "port").value == "5432");
+    CHECK(sorted(lazyConfig) == sorted(config));
+    roundTrip(lazyConfig, dir, lazy);
+
+    // sorted dumps do not depend on the order the entries were loaded in
+    fs::path reversed = writeFile(dir / "reversed.cfg", "[b]\ny = 2\nx = 1\n[a]\nk = v\n");
+    fs::path forward = writeFile(dir / "forward.cfg", "[a]\nk = v\n[b]\nx = 1\ny = 2\n");
+    cfgparser::Config first(reversed), second(forward);
+    CHECK(sorted(first) == sorted(second));
+    CHECK(sorted(first) == "[a]\nk = v\n[b]\nx = 1\ny = 2\n");
+    return 0;
+}
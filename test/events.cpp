@@ -0,0 +1,93 @@
+// parseEvents() reports the lines in file order with includes in place, and fails where and how
+// loading a config fails.
+#include "cfg_parser.hpp"
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+// every event as one line of text
+class Recorder : public cfgparser::EventHandler {
+   public:
+    std::string log;
+
+    void fileBegin(const cfgparser::errhandle::StackTrace& trace) override {
+        log += "begin " + trace.back().file.filename().string() + " " + std::to_string(trace.size()) + "\n";
+    }
+    void fileEnd(const cfgparser::errhandle::StackTrace& trace) override {
+        log += "end " + trace.back().file.filename().string() + "\n";
+    }
+    void sectionBegin(cfgparser::SectionType type, std::string_view name) override {
+        log += "section " + std::to_string(type) + " '" + std::string(name) + "'\n";
+    }
+    void sectionEnd(cfgparser::SectionType type, std::string_view name) override {
+        log += "/section " + std::to_string(type) + " '" + std::string(name) + "'\n";
+    }
+    void entry(std::string_view key, std::string_view value) override {
+        log += "  " + std::string(key) + "=" + std::string(value) + "\n";
+    }
+    void listItem(std::string_view value) override { log += "  " + std::string(value) + "\n"; }
+};
+
+// the error of parseEvents() must be the one of loading the same file
+static void checkSameError(const fs::path& root) {
+    Recorder recorder;
+    std::string error = thrown([&] { cfgparser::parseEvents(root, recorder); });
+    CHECK(!error.empty());
+    CHECK(error == thrown([&] { cfgparser::Config config(root); }));
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+    fs::create_directories(dir / "sub");
+    writeFile(dir / "sub" / "part.cfg", "[part]\nb = 2\n{list}\nx\n");
+    fs::path root = writeFile(
+        dir / "root.cfg", "top = 1\n[s]\na = 1\n!include sub/part.cfg\nc = 3\n<o>\nk = v\n# comment\n\n!include ./sub/part.cfg\n"
+    );
+
+    Recorder recorder;
+    cfgparser::parseEvents(root, recorder);
+    CHECK(recorder.log ==
+          "begin root.cfg 1\n"
+          "section 0 ''\n  top=1\n/section 0 ''\n"
+          "section 0 's'\n  a=1\n/section 0 's'\n"
+          "begin part.cfg 2\n"
+          "section 0 'part'\n  b=2\n/section 0 'part'\n"
+          "section 2 'list'\n  x\n/section 2 'list'\n"
+          "end part.cfg\n"
+          "section 0 's'\n  c=3\n/section 0 's'\n"
+          "section 1 'o'\n  k=v\n/section 1 'o'\n"
+          "begin part.cfg 2\n"
+          "section 0 'part'\n  b=2\n/section 0 'part'\n"
+          "section 2 'list'\n  x\n/section 2 'list'\n"
+          "end part.cfg\n"
+          "end root.cfg\n");
+
+    // several files, one after the other
+    recorder.log.clear();
+    cfgparser::parseEvents(std::vector<fs::path>{dir / "sub" / "part.cfg", dir / "sub" / "part.cfg"}, recorder);
+    CHECK(recorder.log.find("end part.cfg\nbegin part.cfg 1\n") != std::string::npos);
+
+    // lines that do not parse, in the file given and in an include
+    checkSameError(writeFile(dir / "line.cfg", "[s]\na = 1\nno delimiter\n"));
+    checkSameError(writeFile(dir / "header.cfg", "[s]\na = 1\n<broken\n"));
+    checkSameError(writeFile(dir / "command.cfg", "a = 1\n!includ x.cfg\n"));
+    writeFile(dir / "sub" / "bad.cfg", "[s]\n\nbad line\n");
+    checkSameError(writeFile(dir / "nested.cfg", "a = 1\n!include sub/bad.cfg\n"));
+    checkSameError(writeFile(dir / "missing.cfg", "a = 1\n\n!include sub/none.cfg\n"));
+
+    // loops, also through another spelling of the path and a link
+    checkSameError(writeFile(dir / "self.cfg", "!include ./self.cfg\n"));
+    writeFile(dir / "sub" / "back.cfg", "!include ../sub/../loop.cfg\n");
+    checkSameError(writeFile(dir / "loop.cfg", "a = 1\n!include sub/back.cfg\n"));
+    fs::create_symlink(dir / "linked.cfg", dir / "link.cfg");
+    checkSameError(writeFile(dir / "linked.cfg", "!include link.cfg\n"));
+
+    // the handler's own exceptions stop parsing with the stack trace
+    class Failing : public Recorder {
+        void listItem(std::string_view) override { throw std::runtime_error("no lists"); }
+    } failing;
+    std::string error = thrown([&] { cfgparser::parseEvents(root, failing); });
+    CHECK(error == "Config parser: no lists\nStack trace: \n" + (dir / "sub" / "part.cfg").string() + ":4\n" + root.string() + ":4");
+    return 0;
+}
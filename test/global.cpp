@@ -0,0 +1,38 @@
+// The global config can be read from many threads while new configs are published.
+#include "cfg_parser.hpp"
+
+#include <thread>
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+    CHECK(thrown([] { cfgparser::getConfig(); }) == "Global config parser is not initialized");
+
+    std::vector<cfgparser::Config> configs;
+    for (int i = 0; i < 4; ++i)
+        configs.emplace_back(writeFile(dir / ("v" + std::to_string(i) + ".cfg"), "version = " + std::to_string(i) + "\n"));
+    cfgparser::publishConfig(configs[0]);
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            int last = 0;
+            while (!stop.load()) {
+                // a reader never sees an older config than one it saw before
+                int version = t % 2 ? cfgparser::getConfig()->get("version").asInt() : cfgparser::readConfig().get("version").asInt();
+                CHECK(version >= last);
+                last = version;
+            }
+        });
+    }
+    for (int round = 0; round < 2000; ++round) cfgparser::publishConfig(configs[std::min(3, 1 + round / 500)]);
+    stop = true;
+    for (std::thread& reader : readers) reader.join();
+    CHECK(cfgparser::getConfig()->get("version").asInt() == 3);
+    CHECK(cfgparser::readConfig().get("version").asInt() == 3);
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Options::incremental: refresh() reads again only the files that changed and merges the rest
+// from what the refreshed config kept.
+#include "cfg_parser.hpp"
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+// rewrites a file and moves its modification time on, so the change is seen even when the
+// size and the clock tick are the same
+static void edit(const fs::path& path, const std::string& text) {
+    fs::file_time_type before = fs::last_write_time(path);
+    writeFile(path, text);
+    fs::last_write_time(path, before + std::chrono::seconds(1));
+}
+
+// names of the files the last load of 'config' went through, in load order, '*' for reused ones
+static std::string files(cfgparser::Config& config) {
+    std::string res;
+    for (const cfgparser::LoadStats::File& file : config->getLoadStats()->files)
+        res += file.path.filename().string() + (file.reused ? "* " : " ");
+    return res;
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+    writeFile(dir / "a.cfg", "[a]\nkey = 1\n");
+    writeFile(dir / "b.cfg", "[b]\nkey = 1\n");
+    fs::path root = writeFile(dir / "root.cfg", "!include a.cfg\n!include b.cfg\n[root]\nkey = 1\n");
+
+    cfgparser::Options options;
+    options.incremental = true;
+    options.stats = true;
+    cfgparser::Config config(root, options);
+    CHECK(files(config) == "root.cfg a.cfg b.cfg ");
+
+    // nothing changed, nothing is read
+    config = cfgparser::Config(config->refresh());
+    CHECK(files(config) == "root.cfg* a.cfg* b.cfg* ");
+    CHECK(config->get("b", "key").value == "1");
+
+    // a changed include is read again, the rest is reused
+    edit(dir / "b.cfg", "[b]\nkey = 2\n");
+    config = cfgparser::Config(config->refresh());
+    CHECK(files(config) == "root.cfg* a.cfg* b.cfg ");
+    CHECK(config->get("a", "key").value == "1");
+    CHECK(config->get("b", "key").value == "2");
+
+    // an include removed from the including file takes its sections with it
+    edit(root, "!include a.cfg\n[root]\nkey = 2\n");
+    config = cfgparser::Config(config->refresh());
+    CHECK(files(config) == "root.cfg a.cfg* ");
+    CHECK(!config->contains("b", "key"));
+    CHECK(config->get("root", "key").value == "2");
+
+    // and comes back read from the file, not from the config that dropped it
+    edit(dir / "b.cfg", "[b]\nkey = 3\n");
+    edit(root, "!include a.cfg\n!include b.cfg\n[root]\nkey = 3\n");
+    config = cfgparser::Config(config->refresh());
+    CHECK(files(config) == "root.cfg a.cfg* b.cfg ");
+    CHECK(config->get("b", "key").value == "3");
+
+    // an edit that makes a loop fails like a full load and leaves the refreshed config alone
+    edit(dir / "a.cfg", "!include root.cfg\n[a]\nkey = 4\n");
+    std::string error = thrown([&] { config->refresh(); });
+    CHECK(error.find("file loop found") != std::string::npos);
+    CHECK(error == thrown([&] { cfgparser::Config(root, options); }));
+    CHECK(config->get("a", "key").value == "1");
+
+    // undone, the refresh picks up from the same config
+    edit(dir / "a.cfg", "[a]\nkey = 5\n");
+    config = cfgparser::Config(config->refresh());
+    CHECK(files(config) == "root.cfg* a.cfg b.cfg* ");
+    CHECK(config->get("a", "key").value == "5");
+    return 0;
+}
@@ -0,0 +1,117 @@
+// The key index of ordered and list sections follows every change made through the container,
+// also edits in place that keep the buffer and the size.
+#include "cfg_parser.hpp"
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+// enough entries for the index to be used
+static const size_t entries = 40;
+
+static cfgparser::OrderedEntries ordered(const std::string& prefix) {
+    cfgparser::OrderedEntries res;
+    for (size_t i = 0; i < entries; ++i) res.emplace_back(prefix + std::to_string(i), cfgparser::Value(std::to_string(i)));
+    return res;
+}
+
+// looked up twice, so that the second lookup goes through a freshly built index
+static bool has(const cfgparser::OrderedEntries& section, const std::string& key) {
+    bool first = section.find(key) != section.end();
+    CHECK((section.find(key) != section.end()) == first);
+    return first;
+}
+static bool has(const cfgparser::ListEntries& list, const std::string& item) {
+    bool first = list.contains(item);
+    CHECK(list.contains(item) == first);
+    return first;
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+
+    cfgparser::OrderedEntries section = ordered("k");
+    CHECK(has(section, "k5"));
+
+    // renamed through operator[], at(), front(), back() and iterators
+    section[5].first = "five";
+    CHECK(has(section, "five") && !has(section, "k5"));
+    section.at(6).first = "six";
+    CHECK(has(section, "six") && !has(section, "k6"));
+    section.front().first = "first";
+    section.back().first = "last";
+    CHECK(has(section, "first") && has(section, "last") && !has(section, "k0"));
+    for (auto& [key, value] : section) key += "+";
+    CHECK(has(section, "five+") && !has(section, "five"));
+    section.rbegin()->first = "end";
+    CHECK(has(section, "end"));
+    section.data()[1].first = "one";
+    CHECK(has(section, "one"));
+
+    // through the iterator the non-const find() returned
+    section.find("k7+")->first = "seven";
+    CHECK(has(section, "seven") && !has(section, "k7+"));
+
+    // a key renamed into an earlier duplicate: the first occurrence wins
+    section[20].first = "k30+";
+    CHECK(section.find("k30+") - section.begin() == 20);
+
+    // refilled to the same size in the same buffer
+    const void* buffer = section.data();
+    section.assign(entries, {"same", cfgparser::Value("x")});
+    CHECK(section.data() == buffer);
+    CHECK(has(section, "same") && !has(section, "seven"));
+    cfgparser::OrderedEntries other = ordered("o");
+    section = other;
+    CHECK(has(section, "o3") && !has(section, "same"));
+    section.erase(section.begin() + 3);
+    section.insert(section.begin() + 3, {"three", cfgparser::Value("3")});
+    CHECK(has(section, "three") && !has(section, "o3"));
+    section.pop_back();
+    section.push_back({"back", cfgparser::Value("b")});
+    CHECK(has(section, "back"));
+
+    // swapped with another section of the same size
+    cfgparser::OrderedEntries swapped = ordered("s");
+    CHECK(has(swapped, "s1"));
+    section.swap(swapped);
+    CHECK(has(section, "s1") && !has(section, "back"));
+    CHECK(has(swapped, "back") && !has(swapped, "s1"));
+
+    // a reference kept from before the last lookup needs reindex()
+    std::string& kept = section[2].first;
+    CHECK(has(section, "s2"));
+    kept = "two";
+    section.reindex();
+    CHECK(has(section, "two") && !has(section, "s2"));
+
+    // lists
+    cfgparser::ListEntries list;
+    for (size_t i = 0; i < entries; ++i) list.emplace_back("item" + std::to_string(i));
+    CHECK(has(list, "item3"));
+    list[3].value = "three";
+    CHECK(has(list, "three") && !has(list, "item3"));
+    for (cfgparser::Value& item : list) item.value += "!";
+    CHECK(has(list, "three!") && !has(list, "three"));
+    list.assign(entries, cfgparser::Value("all"));
+    CHECK(has(list, "all") && !has(list, "three!"));
+
+    // sections of a loaded config, edited in place between lookups
+    std::string text = "<o>\n";
+    for (size_t i = 0; i < entries; ++i) text += "k" + std::to_string(i) + " = " + std::to_string(i) + "\n";
+    text += "{l}\n";
+    for (size_t i = 0; i < entries; ++i) text += "item" + std::to_string(i) + "\n";
+    cfgparser::Config config(writeFile(dir / "root.cfg", text));
+    CHECK(config->getOrdered("o", "k9").value == "9");
+    CHECK(config->getOrdered("o", "k9").value == "9");
+    config->getOrderedSection("o")[9].first = "nine";
+    CHECK(config->findOrdered("o", "k9") == nullptr);
+    CHECK(config->getOrdered("o", "nine").value == "9");
+    CHECK(config->getOrdered("o", "nine").value == "9");
+    config->getOrdered("o", "nine").value = "changed";
+    CHECK(config->findOrdered("o", "nine")->value == "changed");
+    CHECK(config->containsInList("l", "item4"));
+    config->getList("l")[4].value = "four";
+    CHECK(config->containsInList("l", "four") && !config->containsInList("l", "item4"));
+    return 0;
+}
@@ -0,0 +1,60 @@
+// Options::lazy reports the same errors at the same places as an eager load, and is not
+// affected by files changed after loading.
+#include "cfg_parser.hpp"
+
+#include <algorithm>
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+static std::string loadError(const fs::path& root, bool lazy) {
+    cfgparser::Options options;
+    options.lazy = lazy;
+    return thrown([&] { cfgparser::Config config(root, options); });
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+    writeFile(dir / "f2.cfg", "[inner]\na = 1\nbroken\n");
+    // the included file fails before the line after the include does
+    fs::path f1 = writeFile(dir / "f1.cfg", "[outer]\n!include f2.cfg\nb = 2\n[bad\n");
+    std::string eager = loadError(f1, false);
+    CHECK(eager.find((dir / "f2.cfg").string() + ":3") != std::string::npos);
+    CHECK(eager.find((dir / "f1.cfg").string() + ":2") != std::string::npos);
+    CHECK(loadError(f1, true) == eager);
+
+    // an error of the file itself, after an include that loads
+    writeFile(dir / "f3.cfg", "[inner]\na = 1\n");
+    fs::path f4 = writeFile(dir / "f4.cfg", "!include f3.cfg\n[outer]\nbroken\n");
+    eager = loadError(f4, false);
+    CHECK(eager.find((dir / "f4.cfg").string() + ":3") != std::string::npos);
+    CHECK(loadError(f4, true) == eager);
+
+    cfgparser::Options options;
+    options.lazy = true;
+    cfgparser::Config config(dir / "f3.cfg", options);
+    CHECK(config->get("inner", "a").value == "1");
+
+    // Files edited in place after loading: truncated, refilled to the same size and grown.
+    // Sections used afterwards come from the text as it was loaded.
+    std::string big = "[first]\nkey = 1\n";
+    for (int i = 0; i < 5000; ++i) big += "[s" + std::to_string(i) + "]\nkey = " + std::to_string(i) + "\n";
+    // read on the loading thread and by Options::ioThreads
+    for (unsigned ioThreads : {0u, 2u}) {
+        options.ioThreads = ioThreads;
+        fs::path f5 = writeFile(dir / ("f5-" + std::to_string(ioThreads) + ".cfg"), big);
+        cfgparser::Config edited(f5, options);
+        CHECK(edited->get("first", "key").value == "1");
+        writeFile(f5, "");
+        CHECK(edited->get("s4999", "key").value == "4999");
+        std::string refill = big;
+        std::replace(refill.begin(), refill.end(), '=', ':');
+        writeFile(f5, refill);
+        CHECK(edited->get("s10", "key").value == "10");
+        writeFile(f5, big + big);
+        CHECK(edited->getAllUnordered().size() == 5001);
+        CHECK(edited->get("s2000", "key").value == "2000");
+    }
+    return 0;
+}
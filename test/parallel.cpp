@@ -0,0 +1,101 @@
+// Loading with threads, shards and ioThreads gives the config or the error of the serial load.
+#include "cfg_parser.hpp"
+
+#include <random>
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+// dump of the loaded config, or the error it threw
+static std::string load(const fs::path& root, cfgparser::Options options) {
+    std::string res;
+    std::string error = thrown([&] {
+        cfgparser::DumpOptions dumpOptions;
+        dumpOptions.sorted = true;
+        res = cfgparser::Config(root, options)->dump(dumpOptions);
+    });
+    return error.empty() ? res : "error: " + error;
+}
+
+static void checkSame(const fs::path& root) {
+    cfgparser::Options serial;
+    std::string expected = load(root, serial);
+    for (unsigned threads : {2u, 4u, 8u}) {
+        for (size_t shardSize : {size_t(0), size_t(1), size_t(40), size_t(200)}) {
+            cfgparser::Options options;
+            options.threads = threads;
+            options.shardSize = shardSize;
+            CHECK(load(root, options) == expected);
+            options.ioThreads = 2;
+            CHECK(load(root, options) == expected);
+        }
+    }
+    cfgparser::Options options;
+    options.ioThreads = 3;
+    CHECK(load(root, options) == expected);
+}
+
+// a file of 'files' with random sections, repeated keys and sections, includes anywhere (loops
+// among them) and now and then a line that does not parse
+static std::string randomFile(std::mt19937& random, size_t files, bool errors) {
+    auto pick = [&](size_t n) { return static_cast<size_t>(random() % n); };
+    std::string text;
+    size_t lines = 5 + pick(60);
+    for (size_t i = 0; i < lines; ++i) {
+        switch (pick(12)) {
+            case 0:
+                text += "[u" + std::to_string(pick(4)) + "]\n";
+                break;
+            case 1:
+                text += "<o" + std::to_string(pick(3)) + ">\n";
+                break;
+            case 2:
+                text += "{l" + std::to_string(pick(3)) + "}\n";
+                break;
+            case 3:
+                if (pick(4) == 0) text += "!include f" + std::to_string(pick(files)) + ".cfg\n";
+                break;
+            case 4:
+                text += "# comment\n";
+                break;
+            case 5:
+                text += "\n";
+                break;
+            case 6:
+                if (errors && pick(8) == 0) text += pick(2) ? "[broken\n" : "no delimiter here\n";
+                break;
+            default:
+                text += "k" + std::to_string(pick(6)) + " = v" + std::to_string(random() % 1000) + "\n";
+        }
+    }
+    return text;
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+
+    // a section header exactly at a shard cut, keys before the first header of a piece, an
+    // include and an error in the last piece
+    fs::path root = writeFile(
+        dir / "cuts.cfg",
+        "a = 1\n[s]\nb = 2\n<o>\nx = 1\nx = 2\n{l}\nitem\n[s]\nc = 3\n!include part.cfg\n[t]\nd = 4\n"
+    );
+    writeFile(dir / "part.cfg", "[s]\nb = included\n<o>\ny = 1\n");
+    checkSame(root);
+    std::ofstream(root, std::ios::app) << "[t]\ne = 5\nbroken line\nf = 6\n";
+    checkSame(root);
+    writeFile(dir / "part.cfg", "[p]\n!include cuts.cfg\n");
+    checkSame(root);
+
+    std::mt19937 random(20240611);
+    for (int round = 0; round < 60; ++round) {
+        fs::path sub = dir / std::to_string(round);
+        fs::create_directories(sub);
+        const size_t files = 1 + round % 5;
+        bool errors = round % 3 == 0;
+        for (size_t i = 0; i < files; ++i) writeFile(sub / ("f" + std::to_string(i) + ".cfg"), randomFile(random, files, errors));
+        checkSame(sub / "f0.cfg");
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+// Options::processCache keeps the files a load parsed, whichever threads parsed them.
+#include "cfg_parser.hpp"
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+// files of the second load that were taken from the cache
+static size_t reused(const fs::path& root, cfgparser::Options options) {
+    cfgparser::_Config::clearProcessCache();
+    options.processCache = true;
+    options.stats = true;
+    cfgparser::Config first(root, options);
+    cfgparser::Config second(root, options);
+    size_t res = 0;
+    for (const cfgparser::LoadStats::File& file : second->getLoadStats()->files) res += file.reused;
+    CHECK(second->get("common", "a").value == "1");
+    return res;
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+    fs::create_directories(dir / "sub");
+    writeFile(dir / "common.cfg", "[common]\na = 1\n");
+    // the same file spelled two ways
+    writeFile(dir / "sub" / "part.cfg", "!include ../common.cfg\n[part]\nb = 2\n");
+    fs::path root = writeFile(dir / "root.cfg", "!include common.cfg\n!include sub/part.cfg\n!include ./sub/../common.cfg\n[root]\nc = 3\n");
+    const size_t files = 5;
+
+    cfgparser::Options options;
+    options.threads = 1;
+    CHECK(reused(root, options) == files);
+    options.threads = 2;
+    CHECK(reused(root, options) == files);
+    options.threads = 1;
+    options.ioThreads = 2;
+    CHECK(reused(root, options) == files);
+    return 0;
+}
@@ -0,0 +1,19 @@
+#!/bin/sh
+# Builds and runs every test in this directory, stops at the first failing one.
+#   test/run.sh
+# CXX, CXXFLAGS and BUILD (build directory, test/build) can be set in the environment.
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--O1 -g}
+BUILD=${BUILD:-build}
+
+mkdir -p "$BUILD"
+for source in *.cpp; do
+    name=${source%.cpp}
+    $CXX -std=c++20 $CXXFLAGS -pthread -I../src "$source" -o "$BUILD/$name"
+    rm -rf "$BUILD/$name.data"
+    mkdir "$BUILD/$name.data"
+    "$BUILD/$name" "$BUILD/$name.data"
+    echo "$name: ok"
+done
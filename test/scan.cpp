@@ -0,0 +1,61 @@
+// Every scan kernel the CPU supports finds the same lines and delimiters as the scalar one,
+// around the 16 and 32 byte block edges and on bytes above 0x7f.
+#include "cfg_parser.hpp"
+
+#include <random>
+
+#include "check.hpp"
+
+using cfgparser::scan::detail::Kernel;
+
+static void compare(Kernel kernel, const std::string& text, std::string_view token) {
+    for (bool newlines : {false, true}) {
+        for (size_t pos = 0; pos <= text.size(); ++pos) {
+            size_t expected, found;
+            size_t nl = cfgparser::scan::detail::kernelScalar(text.data(), text.size(), pos, token, newlines, &expected);
+            CHECK(kernel(text.data(), text.size(), pos, token, newlines, &found) == nl);
+            CHECK(found == expected);
+        }
+    }
+}
+
+int main(int, char**) {
+    std::vector<Kernel> kernels;
+#if CFGPARSER_HAS_X86_SIMD
+    kernels.push_back(cfgparser::scan::detail::kernelSse2);
+    if (__builtin_cpu_supports("avx2")) kernels.push_back(cfgparser::scan::detail::kernelAvx2);
+#endif
+    kernels.push_back(cfgparser::scan::detail::kernel);
+
+    const std::vector<std::string> tokens = {" = ", "=", ":", "::", "\xc3\xa9", "\xff", "ab=cd"};
+    // a token or a newline as the last byte, and just before or after every block edge
+    for (Kernel kernel : kernels) {
+        for (std::string_view token : tokens) {
+            for (size_t size = 1; size <= 70; ++size) {
+                for (size_t at = 0; at + token.size() <= size; ++at) {
+                    std::string text(size, 'x');
+                    text.replace(at, token.size(), token);
+                    compare(kernel, text, token);
+                    text[size - 1] = '\n';
+                    compare(kernel, text, token);
+                }
+            }
+        }
+    }
+
+    // random text over a small alphabet, so tokens, partial tokens and newlines are frequent
+    const std::string alphabet = "ab=:: \r\n\xc3\xa9\xff\x80";
+    std::mt19937 random(1);
+    for (int round = 0; round < 2000; ++round) {
+        std::string text(random() % 130, ' ');
+        for (char& c : text) c = alphabet[random() % alphabet.size()];
+        for (Kernel kernel : kernels)
+            for (std::string_view token : tokens) compare(kernel, text, token);
+        for (std::string_view token : tokens) {
+            CHECK(cfgparser::scan::find(text, token) == std::string_view(text).find(token));
+            size_t pos = random() % (text.size() + 1);
+            CHECK(cfgparser::scan::find(text, token, pos) == std::string_view(text).find(token, pos));
+        }
+    }
+    return 0;
+}
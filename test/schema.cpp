@@ -0,0 +1,45 @@
+// Schema reads the keys it declares; other keys of its sections are errors only with strictSchema.
+#include "cfg_parser.hpp"
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+struct db_host {
+    static constexpr std::string_view section = "DatabaseConnection";
+    static constexpr std::string_view key = "db_host";
+    using type = std::string;
+    static constexpr std::string_view defaultValue = "localhost";
+};
+struct db_port {
+    static constexpr std::string_view section = "DatabaseConnection";
+    static constexpr std::string_view key = "db_port";
+    using type = int;
+};
+struct db_timeout {
+    static constexpr std::string_view section = "DatabaseConnection";
+    static constexpr std::string_view key = "db_timeout";
+    using type = std::chrono::milliseconds;
+};
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+    cfgparser::Config config(writeFile(dir / "db.cfg", "[DatabaseConnection]\ndb_port = 3306\ndb_user = reader\ndb_name = app\n"));
+
+    // part of a section
+    cfgparser::Schema<db_host, db_port> db(config);
+    CHECK(db.get<db_host>() == "localhost");
+    CHECK(db.get<db_port>() == 3306);
+
+    std::string error = thrown([&] { cfgparser::Schema<db_host, db_port> strict(config, cfgparser::strictSchema); });
+    CHECK(error == "Config schema:\nunknown key 'db_name' in section 'DatabaseConnection'\n"
+                   "unknown key 'db_user' in section 'DatabaseConnection'");
+
+    // missing keys are reported in both modes, before unknown ones
+    error = thrown([&] { cfgparser::Schema<db_port, db_timeout> lenient(config); });
+    CHECK(error == "Config schema:\nmissing key 'db_timeout' in section 'DatabaseConnection'");
+    error = thrown([&] { cfgparser::Schema<db_port, db_timeout> strict(config, cfgparser::strictSchema); });
+    CHECK(error.find("missing key 'db_timeout'") < error.find("unknown key 'db_name'"));
+    CHECK(error.find("unknown key 'db_user'") != std::string::npos);
+    return 0;
+}
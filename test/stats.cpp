@@ -0,0 +1,66 @@
+// Options::stats counts allocations without changing how files are merged: sections and map nodes
+// of the parsed files still change owner instead of being copied.
+#include "cfg_parser.hpp"
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+static size_t allocations = 0;
+
+// the replacements below pair malloc with free themselves, GCC only sees new paired with free
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+// std::pmr::new_delete_resource() allocates through the aligned forms
+void* operator new(size_t size, std::align_val_t align) {
+    ++allocations;
+    size_t a = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// heap allocations made by loading 'root'
+static size_t load(const fs::path& root, bool stats) {
+    cfgparser::Options options;
+    options.stats = stats;
+    size_t before = allocations;
+    cfgparser::Config config(root, options);
+    size_t res = allocations - before;
+    CHECK(config->get("shared", "a0").value == "1");
+    CHECK(config->get("shared", "b999").value == "2");
+    CHECK(config->getAllUnordered().at("shared").size() == 2000);
+    if (stats) CHECK(config->getLoadStats()->allocations > 0);
+    return res;
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+    const int keys = 1000;
+    std::string part = "[shared]\n", root = "!include part.cfg\n[shared]\n";
+    for (int i = 0; i < keys; ++i) {
+        part += "a" + std::to_string(i) + " = 1\n";
+        root += "b" + std::to_string(i) + " = 2\n";
+    }
+    writeFile(dir / "part.cfg", part);
+    fs::path rootPath = writeFile(dir / "root.cfg", root);
+
+    size_t plain = load(rootPath, false);
+    size_t counted = load(rootPath, true);
+    // the stats themselves take a few allocations, copying the sections would take one per key
+    CHECK(counted < plain + keys / 10);
+    return 0;
+}
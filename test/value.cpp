@@ -0,0 +1,45 @@
+// Value converts once and keeps the typed results in a block allocated on the first conversion.
+#include "cfg_parser.hpp"
+
+#include <thread>
+
+#include "check.hpp"
+
+using cfgparser::Value;
+
+int main(int, char**) {
+    // a value that is never converted carries one pointer next to its text
+    static_assert(sizeof(Value) == sizeof(std::string) + sizeof(void*));
+
+    Value number("42");
+    CHECK(number.asInt() == 42);
+    CHECK(number.asDouble() == 42.0);
+    CHECK(number.as<unsigned>() == 42u);
+    CHECK(!number.tryAs<bool>());
+
+    // copies and moves keep the results, assignments replace them
+    Value copy = number;
+    CHECK(copy.asLongLong() == 42);
+    Value moved = std::move(copy);
+    CHECK(moved.asInt() == 42);
+    moved = Value("true");
+    CHECK(moved.asBool());
+    CHECK(!moved.tryAs<int>());
+    moved = number;
+    CHECK(moved.asInt() == 42);
+    moved = moved;
+    CHECK(moved.asInt() == 42);
+
+    // first conversions racing on one value
+    for (int round = 0; round < 100; ++round) {
+        Value shared(std::to_string(round));
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t)
+            readers.emplace_back([&] {
+                CHECK(shared.asInt() == round);
+                CHECK(shared.asDouble() == round);
+            });
+        for (std::thread& reader : readers) reader.join();
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+// ConfigWatcher reloads the global config when a file changes and leaks nothing when it fails.
+#include "cfg_parser.hpp"
+
+#include <thread>
+
+#include "check.hpp"
+
+namespace fs = std::filesystem;
+
+#if CFGPARSER_HAS_INOTIFY
+
+static size_t openFiles() {
+    return std::distance(fs::directory_iterator("/proc/self/fd"), fs::directory_iterator());
+}
+
+int main(int, char** argv) {
+    fs::path dir = fs::absolute(argv[1]);
+
+    // nothing published yet
+    size_t before = openFiles();
+    CHECK(thrown([] { cfgparser::ConfigWatcher watcher; }) == "Global config parser is not initialized");
+    CHECK(openFiles() == before);
+
+    writeFile(dir / "part.cfg", "value = 1\n");
+    fs::path root = writeFile(dir / "root.cfg", "!include part.cfg\n");
+    cfgparser::initConfig(root);
+    {
+        cfgparser::ConfigWatcher watcher(std::chrono::milliseconds(10));
+        // edited in place, the included file
+        writeFile(dir / "part.cfg", "value = 2\n");
+        for (int i = 0; i < 500 && cfgparser::getConfig()->get("value").asInt() != 2; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        CHECK(cfgparser::getConfig()->get("value").asInt() == 2);
+    }
+    CHECK(openFiles() == before);
+    return 0;
+}
+
+#else
+
+int main(int, char**) { return 0; }
+
+#endif